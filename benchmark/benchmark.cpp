@@ -0,0 +1,279 @@
+#include "vector2d.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+/**
+ * The benchmark of vector2d against std::vector<std::vector<T>> and a plain CSR table.
+ *
+ * Usage: benchmark [vector2d|nested|csr|all] [nrow] [seed]
+ *
+ * The peak RSS is the peak of the whole process, so run one container per process to compare it.
+ */
+
+namespace
+{
+    using value_type = double;
+    using clock_type = std::chrono::steady_clock;
+
+    // The CSR baseline, row i is values[offsets[i], offsets[i + 1]).
+    struct csr_table
+    {
+        std::vector<size_t> offsets{ 0 };
+        std::vector<value_type> values;
+    };
+
+    using nested_table = std::vector<std::vector<value_type>>;
+
+    // Prevent the compiler from removing the measured work.
+    volatile double g_sink = 0;
+
+    size_t peak_rss_kb()
+    {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters;
+        if (!::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters))) { return 0; }
+        return static_cast<size_t>(counters.PeakWorkingSetSize / 1024);
+#else
+        struct rusage usage;
+        if (::getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+#ifdef __APPLE__
+        return static_cast<size_t>(usage.ru_maxrss / 1024);
+#else
+        return static_cast<size_t>(usage.ru_maxrss);
+#endif
+#endif
+    }
+
+    // The row lengths of a distribution.
+    std::vector<size_t> make_lengths(std::string const& distribution, size_t nrow, std::mt19937_64& rng)
+    {
+        std::vector<size_t> lengths(nrow);
+        if (distribution == "fixed16")
+        {
+            std::fill(lengths.begin(), lengths.end(), 16);
+        }
+        else if (distribution == "uniform0-8")
+        {
+            std::uniform_int_distribution<size_t> dist(0, 8);
+            for (auto& length : lengths) { length = dist(rng); }
+        }
+        else if (distribution == "uniform0-64")
+        {
+            std::uniform_int_distribution<size_t> dist(0, 64);
+            for (auto& length : lengths) { length = dist(rng); }
+        }
+        else
+        {
+            // A heavy tail: most rows are short and a few rows have thousands of elements.
+            std::uniform_real_distribution<double> dist(0.0, 1.0);
+            for (auto& length : lengths) { length = static_cast<size_t>(std::min(std::pow(1.0 - dist(rng), -1.5), 4096.0)) - 1; }
+        }
+        return lengths;
+    }
+
+    /* begin operations of containers */
+
+    void build(std::vector2d<value_type>& table, std::vector<size_t> const& lengths)
+    {
+        for (size_t length : lengths) { table.push_back(std::vector<value_type>(length, 1.0)); }
+    }
+    void build(nested_table& table, std::vector<size_t> const& lengths)
+    {
+        for (size_t length : lengths) { table.emplace_back(length, 1.0); }
+    }
+    void build(csr_table& table, std::vector<size_t> const& lengths)
+    {
+        for (size_t length : lengths)
+        {
+            table.values.insert(table.values.end(), length, 1.0);
+            table.offsets.push_back(table.values.size());
+        }
+    }
+
+    void push_back(std::vector2d<value_type>& table, size_t row, value_type value) { table[row].push_back(value); }
+    void push_back(nested_table& table, size_t row, value_type value) { table[row].push_back(value); }
+    void push_back(csr_table& table, size_t row, value_type value)
+    {
+        table.values.insert(table.values.begin() + table.offsets[row + 1], value);
+        for (size_t i = row + 1; i < table.offsets.size(); ++i) { ++table.offsets[i]; }
+    }
+
+    void insert_middle(std::vector2d<value_type>& table, std::vector<value_type> const& row)
+    {
+        table.insert(table.begin() + table.size() / 2, &row, &row + 1);
+    }
+    void insert_middle(nested_table& table, std::vector<value_type> const& row)
+    {
+        table.insert(table.begin() + table.size() / 2, row);
+    }
+    void insert_middle(csr_table& table, std::vector<value_type> const& row)
+    {
+        size_t const index = (table.offsets.size() - 1) / 2;
+        table.values.insert(table.values.begin() + table.offsets[index], row.begin(), row.end());
+        table.offsets.insert(table.offsets.begin() + index + 1, table.offsets[index] + row.size());
+        for (size_t i = index + 2; i < table.offsets.size(); ++i) { table.offsets[i] += row.size(); }
+    }
+
+    void erase_middle(std::vector2d<value_type>& table) { table.erase(table.begin() + table.size() / 2); }
+    void erase_middle(nested_table& table) { table.erase(table.begin() + table.size() / 2); }
+    void erase_middle(csr_table& table)
+    {
+        size_t const index = (table.offsets.size() - 1) / 2;
+        size_t const count = table.offsets[index + 1] - table.offsets[index];
+        table.values.erase(table.values.begin() + table.offsets[index], table.values.begin() + table.offsets[index + 1]);
+        table.offsets.erase(table.offsets.begin() + index + 1);
+        for (size_t i = index + 1; i < table.offsets.size(); ++i) { table.offsets[i] -= count; }
+    }
+
+    double scan(std::vector2d<value_type> const& table)
+    {
+        double sum = 0;
+        for (size_t i = 0; i < table.size(); ++i)
+        {
+            for (value_type value : table.row_span(i)) { sum += value; }
+        }
+        return sum;
+    }
+    double scan(nested_table const& table)
+    {
+        double sum = 0;
+        for (auto const& row : table)
+        {
+            for (value_type value : row) { sum += value; }
+        }
+        return sum;
+    }
+    double scan(csr_table const& table)
+    {
+        double sum = 0;
+        for (value_type value : table.values) { sum += value; }
+        return sum;
+    }
+
+    size_t nelement(std::vector2d<value_type> const& table) { return table.nelement(); }
+    size_t nelement(nested_table const& table)
+    {
+        size_t count = 0;
+        for (auto const& row : table) { count += row.size(); }
+        return count;
+    }
+    size_t nelement(csr_table const& table) { return table.values.size(); }
+
+    size_t nrow(std::vector2d<value_type> const& table) { return table.size(); }
+    size_t nrow(nested_table const& table) { return table.size(); }
+    size_t nrow(csr_table const& table) { return table.offsets.size() - 1; }
+
+    // Only vector2d keeps garbage, the others shrink their buffers instead.
+    void compact(std::vector2d<value_type>& table) { table.compact(); }
+    void compact(nested_table& table) { for (auto& row : table) { row.shrink_to_fit(); } }
+    void compact(csr_table& table) { table.values.shrink_to_fit(); }
+
+    double garbage_ratio(std::vector2d<value_type> const& table) { return table.garbage_ratio(); }
+    double garbage_ratio(nested_table const&) { return 0.0; }
+    double garbage_ratio(csr_table const&) { return 0.0; }
+
+    /* end operations of containers */
+
+    template <class F>
+    double seconds(F&& fn)
+    {
+        auto const start = clock_type::now();
+        fn();
+        return std::chrono::duration<double>(clock_type::now() - start).count();
+    }
+
+    void report(char const* container, std::string const& distribution, char const* operation, size_t nop, double elapsed)
+    {
+        double const rate = elapsed > 0 ? static_cast<double>(nop) / elapsed / 1e6 : 0.0;
+        std::printf("%-9s %-12s %-12s %12zu ops %10.3f ms %10.2f Mops/s\n", container, distribution.c_str(), operation, nop,
+            elapsed * 1e3, rate);
+    }
+
+    /**
+     * Run all operations on one container. The operations which are O(n) per call for CSR run fewer times,
+     * the throughput is per operation in any case.
+     */
+    template <class Table>
+    void run(char const* container, std::string const& distribution, size_t nrow_total, unsigned seed, size_t slow_divisor)
+    {
+        std::mt19937_64 rng(seed);
+        std::vector<size_t> const lengths = make_lengths(distribution, nrow_total, rng);
+
+        Table table;
+        report(container, distribution, "construct", nrow_total, seconds([&] { build(table, lengths); }));
+
+        size_t const npush = nrow_total * 4 / slow_divisor;
+        std::vector<size_t> rows(npush);
+        std::uniform_int_distribution<size_t> pick(0, nrow_total - 1);
+        for (auto& row : rows) { row = pick(rng); }
+        report(container, distribution, "push_back", npush, seconds([&] { for (size_t row : rows) { push_back(table, row, 2.0); } }));
+        double const garbage = garbage_ratio(table);
+
+        size_t const nmiddle = std::max<size_t>(nrow_total / 100 / slow_divisor, 1);
+        std::vector<value_type> const middle_row(8, 3.0);
+        report(container, distribution, "insert", nmiddle, seconds([&] { for (size_t i = 0; i < nmiddle; ++i) { insert_middle(table, middle_row); } }));
+        report(container, distribution, "erase", nmiddle, seconds([&] { for (size_t i = 0; i < nmiddle; ++i) { erase_middle(table); } }));
+
+        size_t const nscanned = nelement(table);
+        report(container, distribution, "scan", nscanned, seconds([&] { g_sink = g_sink + scan(table); }));
+
+        report(container, distribution, "compact", nelement(table), seconds([&] { compact(table); }));
+        report(container, distribution, "scan", nscanned, seconds([&] { g_sink = g_sink + scan(table); }));
+
+        Table copied;
+        report(container, distribution, "copy", nelement(table), seconds([&] { copied = table; }));
+        Table moved;
+        size_t const nmoved = nrow(copied);
+        report(container, distribution, "move", nmoved, seconds([&] { moved = std::move(copied); }));
+
+        std::printf("%-9s %-12s rows %zu elements %zu garbage ratio after push_back %.3f peak RSS %zu KB\n\n", container,
+            distribution.c_str(), nrow(moved), nelement(moved), garbage, peak_rss_kb());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string const container = argc > 1 ? argv[1] : "all";
+    size_t const nrow_total = argc > 2 ? static_cast<size_t>(std::stoull(argv[2])) : 100000;
+    unsigned const seed = argc > 3 ? static_cast<unsigned>(std::stoul(argv[3])) : 42;
+
+    if (container != "all" && container != "vector2d" && container != "nested" && container != "csr")
+    {
+        std::fprintf(stderr, "usage: %s [vector2d|nested|csr|all] [nrow] [seed]\n", argv[0]);
+        return 1;
+    }
+    if (nrow_total == 0)
+    {
+        std::fprintf(stderr, "nrow cannot be zero\n");
+        return 1;
+    }
+
+    for (std::string const distribution : { "fixed16", "uniform0-8", "uniform0-64", "heavy-tail" })
+    {
+        if (container == "all" || container == "vector2d") { run<std::vector2d<value_type>>("vector2d", distribution, nrow_total, seed, 1); }
+        if (container == "all" || container == "nested") { run<nested_table>("nested", distribution, nrow_total, seed, 1); }
+        // Every push_back, insert and erase of CSR shifts the whole table.
+        if (container == "all" || container == "csr") { run<csr_table>("csr", distribution, nrow_total, seed, 100); }
+    }
+    return 0;
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "vector2d.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <initializer_list>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace std
+{
+
+    /**
+     * The companion of vector2d for many producers appending whole rows at the same time without locks.
+     *
+     * The elements and the rows are stored in segments which never move once allocated, segment k holds
+     * chunk_size * 2^k slots. A producer reserves a row slot and a range of elements by atomic compare-and-swap
+     * once their segment is allocated, fills the elements, and then publishes the row. A published row could
+     * be read by any thread while other rows are still being appended. A range which would span two segments
+     * starts at the next segment instead, so a row is always contiguous; the skipped slots are counted by
+     * ngarbage().
+     *
+     * Rows can't be modified or removed after they are published, call to_vector2d() once all producers
+     * are done to get a regular vector2d. The elements are value-initialized when their segment is allocated.
+     */
+    template <typename T>
+    class concurrent_vector2d
+    {
+
+    public:
+
+        using value_type = T;
+
+        // chunk_size is the size of the first segment, which is rounded up to a power of 2.
+        explicit concurrent_vector2d(size_t chunk_size = 1024)
+            : m_data(chunk_size)
+            , m_rows(chunk_size)
+        {}
+
+        concurrent_vector2d(concurrent_vector2d const&) = delete;
+        concurrent_vector2d& operator=(concurrent_vector2d const&) = delete;
+
+        /**
+         * Append a row of count elements, fill(std::span<T>) writes the elements before the row is published.
+         * It's safe to call from multiple threads, return the index of the new row. If fill or the allocation of
+         * the elements throws, the row is published as an empty row, its reserved elements are counted by ngarbage(),
+         * and the exception is rethrown, so to_vector2d() still works. If the row slot itself can't be allocated,
+         * no row is added.
+         *
+         * Time complexity: O(count), plus a segment allocation when the reservation enters a new segment.
+         */
+        template <class F>
+        size_t append_row(size_t count, F&& fill);
+
+        size_t push_back(std::span<T const> row)
+        {
+            return this->append_row(row.size(), [row](std::span<T> out) { std::copy(row.begin(), row.end(), out.begin()); });
+        }
+        size_t push_back(std::initializer_list<T> const& row)
+        {
+            return this->push_back(std::span<T const>(row.begin(), row.size()));
+        }
+        size_t push_back(std::vector<T>&& row)
+        {
+            return this->append_row(row.size(), [&row](std::span<T> out) { std::move(row.begin(), row.end(), out.begin()); });
+        }
+
+        // Whether the row is published, a row reserved by append_row() is published when fill returns or throws.
+        bool is_published(size_t index) const noexcept
+        {
+            return index < m_rows.nreserved() && m_rows.find(index) != nullptr && m_rows.find(index)->published.load(std::memory_order_acquire);
+        }
+
+        // Element access, operator[] requires the row to be published.
+        std::span<T const> operator[](size_t index) const
+        {
+            row_record const& record = *m_rows.find(index);
+            return std::span<T const>(record.data, record.size);
+        }
+        std::span<T const> at(size_t index) const
+        {
+            if (!this->is_published(index))
+            {
+                std::ostringstream ms;
+                ms << "ollib::concurrent_vector2d::at(): input index " << index << " is out of range or not published.";
+                throw std::out_of_range(ms.str());
+            }
+            return (*this)[index];
+        }
+
+        // Capacity, the rows and elements which are reserved including the ones being appended.
+        size_t size() const noexcept { return m_rows.nreserved(); }
+        bool empty() const noexcept { return this->size() == 0; }
+        size_t nelement() const noexcept { return m_nelement.load(std::memory_order_relaxed); }
+        // The number of element slots skipped to keep a row in one segment, or left by a row whose fill or allocation threw.
+        size_t ngarbage() const noexcept { return m_ngarbage.load(std::memory_order_relaxed); }
+
+        // Copy the rows into a compacted vector2d, all rows have to be published.
+        template <typename Allocator = std::allocator<T>>
+        vector2d<T, Allocator> to_vector2d(Allocator const& alloc = Allocator()) const;
+
+    private:
+
+        struct row_record
+        {
+            T* data = nullptr;
+            size_t size = 0;
+            std::atomic<bool> published{ false };
+        };
+
+        /**
+         * The array of slots stored in segments of growing size, slot i stays at the same address after
+         * reserve() returns it. Segments are allocated on first use, the first allocation of a segment wins.
+         */
+        template <typename U>
+        class segmented_array
+        {
+
+        public:
+
+            static constexpr size_t max_segments = 48;
+
+            explicit segmented_array(size_t chunk_size) : m_chunk_size(std::bit_ceil(std::max<size_t>(chunk_size, 1))) {}
+            ~segmented_array()
+            {
+                for (auto& segment : m_segments) { delete[] segment.load(std::memory_order_relaxed); }
+            }
+
+            /**
+             * Reserve count contiguous slots, return the first index and the pointer to the first slot. The segment
+             * is allocated before the slots are taken, so nothing is taken if the allocation throws. The slots skipped
+             * to keep the range in one segment are added to wasted if it's given.
+             */
+            std::pair<size_t, U*> reserve(size_t count, std::atomic<size_t>* wasted = nullptr)
+            {
+                size_t ibegin = m_nreserved.load(std::memory_order_relaxed);
+                for (;;)
+                {
+                    size_t first = ibegin;
+                    while (count > 1 && this->segment_of(first + count - 1) != this->segment_of(first))
+                    {
+                        first = this->segment_begin(this->segment_of(first) + 1);
+                    }
+                    size_t const segment = this->segment_of(first);
+                    U* const data = this->segment_data(segment);
+                    if (m_nreserved.compare_exchange_weak(ibegin, first + count, std::memory_order_relaxed))
+                    {
+                        if (wasted && first != ibegin) { wasted->fetch_add(first - ibegin, std::memory_order_relaxed); }
+                        return { first, data + (first - this->segment_begin(segment)) };
+                    }
+                }
+            }
+
+            // The slot at index, or nullptr if its segment isn't allocated yet.
+            U* find(size_t index) const noexcept
+            {
+                size_t const segment = this->segment_of(index);
+                U* data = m_segments[segment].load(std::memory_order_acquire);
+                return data ? data + (index - this->segment_begin(segment)) : nullptr;
+            }
+
+            size_t nreserved() const noexcept { return m_nreserved.load(std::memory_order_acquire); }
+
+        private:
+
+            // Segment k covers [chunk_size * (2^k - 1), chunk_size * (2^(k + 1) - 1)).
+            size_t segment_of(size_t index) const noexcept { return std::bit_width(index / m_chunk_size + 1) - 1; }
+            size_t segment_begin(size_t segment) const noexcept { return m_chunk_size * ((size_t(1) << segment) - 1); }
+
+            U* segment_data(size_t segment)
+            {
+                if (segment >= max_segments)
+                {
+                    std::ostringstream ms;
+                    ms << "ollib::concurrent_vector2d: segment " << segment << " exceeds the maximum number of segments " << max_segments << ".";
+                    throw std::length_error(ms.str());
+                }
+                U* data = m_segments[segment].load(std::memory_order_acquire);
+                if (data) { return data; }
+
+                U* allocated = new U[m_chunk_size << segment]();
+                if (m_segments[segment].compare_exchange_strong(data, allocated, std::memory_order_acq_rel)) { return allocated; }
+                // Another thread allocated the segment first.
+                delete[] allocated;
+                return data;
+            }
+
+            size_t const m_chunk_size;
+            std::atomic<size_t> m_nreserved{ 0 };
+            std::atomic<U*> m_segments[max_segments] = {};
+
+        }; /* end class segmented_array */
+
+        segmented_array<T> m_data;
+        segmented_array<row_record> m_rows;
+        std::atomic<size_t> m_nelement{ 0 };
+        std::atomic<size_t> m_ngarbage{ 0 };
+
+    }; /* end class concurrent_vector2d */
+
+    template <class T>
+    template <class F>
+    size_t concurrent_vector2d<T>::append_row(size_t count, F&& fill)
+    {
+        auto const row = m_rows.reserve(1);
+        T* data = nullptr;
+
+        try
+        {
+            if (count != 0) { data = m_data.reserve(count, &m_ngarbage).second; }
+            fill(std::span<T>(data, count));
+        }
+        catch (...)
+        {
+            // No reader waits for the row forever, it's published with no elements.
+            if (data) { m_ngarbage.fetch_add(count, std::memory_order_relaxed); }
+            row.second->published.store(true, std::memory_order_release);
+            throw;
+        }
+
+        row.second->data = data;
+        row.second->size = count;
+        m_nelement.fetch_add(count, std::memory_order_relaxed);
+        row.second->published.store(true, std::memory_order_release);
+        return row.first;
+    }
+
+    template <class T>
+    template <typename Allocator>
+    vector2d<T, Allocator> concurrent_vector2d<T>::to_vector2d(Allocator const& alloc) const
+    {
+        size_t const nrow = this->size();
+        std::vector<size_t> offsets(1, 0);
+        offsets.reserve(nrow + 1);
+        for (size_t i = 0; i < nrow; ++i)
+        {
+            if (!this->is_published(i))
+            {
+                std::ostringstream ms;
+                ms << "ollib::concurrent_vector2d::to_vector2d(): row " << i << " is not published.";
+                throw std::runtime_error(ms.str());
+            }
+            offsets.push_back(offsets.back() + (*this)[i].size());
+        }
+        if (nrow == 0) { return vector2d<T, Allocator>(alloc); }
+
+        typename vector2d<T, Allocator>::data_type values(alloc);
+        values.reserve(offsets.back());
+        for (size_t i = 0; i < nrow; ++i)
+        {
+            std::span<T const> const row = (*this)[i];
+            values.insert(values.end(), row.begin(), row.end());
+        }
+        return vector2d<T, Allocator>(offsets, std::move(values));
+    }
+
+}  // namespace ollib
@@ -0,0 +1,284 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace std
+{
+
+    /**
+     * The sibling of vector2d whose rows all have N elements, N is known at compile time.
+     *
+     * No metadata is kept per row, row i is the elements [i * N, (i + 1) * N) of one buffer and it's
+     * returned as std::span<T, N>. There is no garbage: erasing a row shifts the following rows down.
+     */
+    template <typename T, size_t N, typename Allocator = std::allocator<T>>
+    class fixed_vector2d
+    {
+        static_assert(N > 0, "fixed_vector2d requires at least one column");
+
+    public:
+
+        using value_type = T;
+        using allocator_type = Allocator;
+        using data_type = std::vector<T, Allocator>;
+        using row_type = std::span<T, N>;
+        using const_row_type = std::span<T const, N>;
+
+        static constexpr size_t ncol = N;
+
+        /**
+         * The random access iterator over the rows, which is dereferenced to std::span<T, N>.
+         */
+        template <typename U>
+        class basic_row_iterator
+        {
+
+        public:
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = std::span<U, N>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = std::span<U, N>;
+
+            basic_row_iterator() = default;
+            explicit basic_row_iterator(U* data) : m_data(data) {}
+            // The iterator converts to its const version.
+            operator basic_row_iterator<U const>() const { return basic_row_iterator<U const>(m_data); }
+
+            reference operator*() const { return reference(m_data, N); }
+            reference operator[](difference_type n) const { return reference(m_data + n * N, N); }
+
+            basic_row_iterator& operator++() { m_data += N; return *this; }
+            basic_row_iterator operator++(int) { basic_row_iterator old = *this; m_data += N; return old; }
+            basic_row_iterator& operator--() { m_data -= N; return *this; }
+            basic_row_iterator operator--(int) { basic_row_iterator old = *this; m_data -= N; return old; }
+            basic_row_iterator& operator+=(difference_type n) { m_data += n * N; return *this; }
+            basic_row_iterator& operator-=(difference_type n) { m_data -= n * N; return *this; }
+            basic_row_iterator operator+(difference_type n) const { return basic_row_iterator(m_data + n * N); }
+            basic_row_iterator operator-(difference_type n) const { return basic_row_iterator(m_data - n * N); }
+            friend basic_row_iterator operator+(difference_type n, basic_row_iterator const& it) { return it + n; }
+            difference_type operator-(basic_row_iterator const& other) const
+            {
+                return (m_data - other.m_data) / static_cast<difference_type>(N);
+            }
+
+            bool operator==(basic_row_iterator const& other) const { return m_data == other.m_data; }
+            bool operator!=(basic_row_iterator const& other) const { return m_data != other.m_data; }
+            bool operator<(basic_row_iterator const& other) const { return m_data < other.m_data; }
+            bool operator>(basic_row_iterator const& other) const { return m_data > other.m_data; }
+            bool operator<=(basic_row_iterator const& other) const { return m_data <= other.m_data; }
+            bool operator>=(basic_row_iterator const& other) const { return m_data >= other.m_data; }
+
+            U* data() const noexcept { return m_data; }
+
+        private:
+
+            U* m_data = nullptr;
+
+        }; /* end class basic_row_iterator */
+
+        using row_iterator = basic_row_iterator<T>;
+        using const_row_iterator = basic_row_iterator<T const>;
+
+        /* begin construction methods */
+        fixed_vector2d() : fixed_vector2d(Allocator()) {}
+        explicit fixed_vector2d(Allocator const& alloc) : m_data(alloc) {}
+
+        // Construct nrow rows of value-initialized elements.
+        explicit fixed_vector2d(size_t nrow, Allocator const& alloc = Allocator()) : m_data(nrow * N, T(), alloc) {}
+
+        // Construct from the rows of N elements each.
+        fixed_vector2d(std::initializer_list<std::array<T, N>> rows, Allocator const& alloc = Allocator())
+            : m_data(alloc)
+        {
+            m_data.reserve(rows.size() * N);
+            for (auto const& row : rows) { m_data.insert(m_data.end(), row.begin(), row.end()); }
+        }
+
+        // Take the row-major elements as the buffer, the size of values must be a multiple of N.
+        explicit fixed_vector2d(data_type&& values)
+            : m_data(std::move(values))
+        {
+            if (m_data.size() % N != 0)
+            {
+                std::ostringstream ms;
+                ms << "ollib::fixed_vector2d(): input " << m_data.size() << " values aren't a multiple of " << N << " columns.";
+                throw std::out_of_range(ms.str());
+            }
+        }
+        /* end construction methods */
+
+        /* begin vector-like methods */
+
+        // Iterators
+        row_iterator begin() noexcept { return row_iterator(m_data.data()); }
+        row_iterator end() noexcept { return row_iterator(m_data.data() + m_data.size()); }
+        const_row_iterator begin() const noexcept { return const_row_iterator(m_data.data()); }
+        const_row_iterator end() const noexcept { return const_row_iterator(m_data.data() + m_data.size()); }
+        const_row_iterator cbegin() const noexcept { return this->begin(); }
+        const_row_iterator cend() const noexcept { return this->end(); }
+
+        // Element access
+        row_type at(size_t index)
+        {
+            this->check_index(index, "at");
+            return (*this)[index];
+        }
+        const_row_type at(size_t index) const
+        {
+            this->check_index(index, "at");
+            return (*this)[index];
+        }
+        row_type operator[](size_t index) noexcept { return row_type(m_data.data() + index * N, N); }
+        const_row_type operator[](size_t index) const noexcept { return const_row_type(m_data.data() + index * N, N); }
+        row_type front() noexcept { return (*this)[0]; }
+        const_row_type front() const noexcept { return (*this)[0]; }
+        row_type back() noexcept { return (*this)[this->size() - 1]; }
+        const_row_type back() const noexcept { return (*this)[this->size() - 1]; }
+        row_type row_span(size_t index) noexcept { return (*this)[index]; }
+        const_row_type row_span(size_t index) const noexcept { return (*this)[index]; }
+
+        // All elements in row-major order.
+        T* data() noexcept { return m_data.data(); }
+        T const* data() const noexcept { return m_data.data(); }
+        std::span<T> elements() noexcept { return std::span<T>(m_data); }
+        std::span<T const> elements() const noexcept { return std::span<T const>(m_data); }
+
+        allocator_type get_allocator() const noexcept { return m_data.get_allocator(); }
+
+        // Capacity
+        size_t size() const noexcept { return m_data.size() / N; }
+        size_t max_size() const noexcept { return m_data.max_size() / N; }
+        bool empty() const noexcept { return m_data.empty(); }
+        size_t capacity() const noexcept { return m_data.capacity() / N; }
+        void reserve(size_t nrow) { m_data.reserve(nrow * N); }
+        void shrink_to_fit() { m_data.shrink_to_fit(); }
+        size_t nelement() const noexcept { return m_data.size(); }
+
+        // Modifiers
+        void clear() noexcept { m_data.clear(); }
+
+        row_iterator insert(const_row_iterator pos, const_row_type row)
+        {
+            size_t const ibegin = pos.data() - m_data.data();
+            // The row might belong to this container, copy it before the buffer moves.
+            std::array<T, N> const tmp = this->to_array(row);
+            m_data.insert(m_data.begin() + ibegin, tmp.begin(), tmp.end());
+            return row_iterator(m_data.data() + ibegin);
+        }
+        row_iterator insert(const_row_iterator pos, std::initializer_list<T> row)
+        {
+            this->check_row(row.size(), "insert");
+            return this->insert(pos, const_row_type(row.begin(), N));
+        }
+
+        row_iterator erase(const_row_iterator first, const_row_iterator last)
+        {
+            size_t const ibegin = first.data() - m_data.data();
+            m_data.erase(m_data.begin() + ibegin, m_data.begin() + (last.data() - m_data.data()));
+            return row_iterator(m_data.data() + ibegin);
+        }
+        row_iterator erase(const_row_iterator pos) { return this->erase(pos, pos + 1); }
+
+        void push_back(const_row_type row)
+        {
+            std::array<T, N> const tmp = this->to_array(row);
+            m_data.insert(m_data.end(), tmp.begin(), tmp.end());
+        }
+        void push_back(std::array<T, N> const& row) { m_data.insert(m_data.end(), row.begin(), row.end()); }
+        void push_back(std::initializer_list<T> row)
+        {
+            this->check_row(row.size(), "push_back");
+            m_data.insert(m_data.end(), row.begin(), row.end());
+        }
+
+        // Add a new row, each of N args constructs one element of the row in place.
+        template <class... Args>
+        row_type emplace_back(Args&&... args)
+        {
+            static_assert(sizeof...(Args) == N, "fixed_vector2d::emplace_back() requires N arguments");
+            if (m_data.size() + N <= m_data.capacity())
+            {
+                (m_data.emplace_back(std::forward<Args>(args)), ...);
+            }
+            else
+            {
+                // args might refer to the elements, so the row is constructed before the buffer grows.
+                std::array<T, N> row{ T(std::forward<Args>(args))... };
+                this->reserve_data(N);
+                for (T& value : row) { m_data.emplace_back(std::move(value)); }
+            }
+            return this->back();
+        }
+
+        void pop_back() { m_data.erase(m_data.end() - N, m_data.end()); }
+
+        void resize(size_t nrow) { m_data.resize(nrow * N); }
+        void resize(size_t nrow, std::array<T, N> const& row)
+        {
+            size_t const old = this->size();
+            if (nrow <= old)
+            {
+                this->resize(nrow);
+                return;
+            }
+            this->reserve_data((nrow - old) * N);
+            for (size_t i = old; i < nrow; ++i) { m_data.insert(m_data.end(), row.begin(), row.end()); }
+        }
+
+        void swap(fixed_vector2d& other) noexcept { m_data.swap(other.m_data); }
+
+        /* end vector-like methods */
+
+    private:
+
+        // Reserve count more elements, the buffer grows geometrically like push_back.
+        void reserve_data(size_t count)
+        {
+            size_t const required = m_data.size() + count;
+            if (required > m_data.capacity()) { m_data.reserve(std::max(required, m_data.capacity() * 2)); }
+        }
+
+        void check_index(size_t index, char const* func) const
+        {
+            if (index >= this->size())
+            {
+                std::ostringstream ms;
+                ms << "ollib::fixed_vector2d::" << func << "(): input index " << index << " is out of range.";
+                throw std::out_of_range(ms.str());
+            }
+        }
+
+        void check_row(size_t size, char const* func) const
+        {
+            if (size != N)
+            {
+                std::ostringstream ms;
+                ms << "ollib::fixed_vector2d::" << func << "(): input row of " << size << " elements doesn't have " << N << " columns.";
+                throw std::out_of_range(ms.str());
+            }
+        }
+
+        static std::array<T, N> to_array(const_row_type row)
+        {
+            std::array<T, N> result;
+            std::copy(row.begin(), row.end(), result.begin());
+            return result;
+        }
+
+        data_type m_data;
+
+    }; /* end class fixed_vector2d */
+
+}  // namespace ollib
@@ -0,0 +1,337 @@
+#pragma once
+
+#include "vector2d.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace std
+{
+
+    /**
+     * The read-only compressed form of a vector2d of integers, e.g. the sorted id lists of adjacency and
+     * posting lists.
+     *
+     * Each row is delta encoded and the deltas are bit-packed in blocks of block_size values. A row is
+     * the varint of its size followed by its blocks, and each block is one header byte, i.e. the bit width
+     * of its deltas, followed by the deltas packed in width bits each. A block whose values aren't
+     * non-decreasing stores the zigzag encoding of its deltas instead, which is marked by the high bit
+     * of the header, so any row could be frozen but sorted rows compress best.
+     *
+     * Row i starts at the byte offsets()[i], which keeps the random row access O(1). A block has a single
+     * bit width, so its decoding loop has no branch per value.
+     */
+    template <typename T>
+    class frozen_vector2d
+    {
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool> && sizeof(T) <= 8,
+            "frozen_vector2d requires an integer type of at most 64 bits");
+
+    public:
+
+        using value_type = T;
+
+        static constexpr size_t block_size = 128;
+
+        frozen_vector2d() : m_offsets(1, 0), m_bytes(padding, 0) {}
+
+        /**
+         * Compress the rows of a vector2d.
+         *
+         * Time complexity: O(n + m), where n = number of rows, m = number of elements
+         */
+        template <typename Allocator, typename Index>
+        explicit frozen_vector2d(vector2d<T, Allocator, Index> const& rows);
+
+        // Capacity
+        size_t size() const noexcept { return m_offsets.size() - 1; }
+        bool empty() const noexcept { return this->size() == 0; }
+        size_t nelement() const noexcept { return m_nelement; }
+        // The bytes of the compressed rows and of the offsets.
+        size_t nbyte() const noexcept { return m_bytes.size() + m_offsets.size() * sizeof(uint64_t); }
+
+        // The byte offset of each row, size() + 1 offsets.
+        std::span<uint64_t const> offsets() const noexcept { return std::span<uint64_t const>(m_offsets); }
+
+        // The number of elements of row index, O(1).
+        size_t row_size(size_t index) const
+        {
+            uint8_t const* in = m_bytes.data() + m_offsets[index];
+            return static_cast<size_t>(read_varint(in));
+        }
+
+        /**
+         * Decode row index into out, which holds row_size(index) elements, return the number of elements.
+         *
+         * Time complexity: O(k), where k = number of elements in the row
+         */
+        size_t decode(size_t index, T* out) const;
+
+        // Decode row index into a new vector, throw if index is out of range.
+        std::vector<T> at(size_t index) const
+        {
+            if (index >= this->size())
+            {
+                std::ostringstream ms;
+                ms << "ollib::frozen_vector2d::at(): input index " << index << " is out of range.";
+                throw std::out_of_range(ms.str());
+            }
+            std::vector<T> row(this->row_size(index));
+            this->decode(index, row.data());
+            return row;
+        }
+        std::vector<T> operator[](size_t index) const
+        {
+            std::vector<T> row(this->row_size(index));
+            this->decode(index, row.data());
+            return row;
+        }
+
+        /**
+         * Call fn(std::span<T const>) for each decoded block of row index in order, the block lives in a
+         * buffer on the stack which is reused by the next block. It scans a row without allocation.
+         */
+        template <class F>
+        void for_each_block(size_t index, F&& fn) const;
+
+        /**
+         * Call fn(index, std::span<T const>) for each row in order, the rows are decoded into one reused buffer.
+         */
+        template <class F>
+        void for_each_row(F&& fn) const;
+
+        // Decompress into a compacted vector2d.
+        template <typename Allocator = std::allocator<T>>
+        vector2d<T, Allocator> to_vector2d(Allocator const& alloc = Allocator()) const;
+
+    private:
+
+        using unsigned_type = std::make_unsigned_t<T>;
+
+        // The header bit of a block of zigzag encoded deltas.
+        static constexpr uint8_t zigzag_flag = 0x80;
+        // The decoder loads 8 bytes and one more byte from the byte of each value, the buffer ends with them.
+        static constexpr size_t padding = 9;
+        static constexpr unsigned value_bits = sizeof(T) * 8;
+
+        void encode_row(std::span<T const> row);
+        void write_varint(uint64_t value);
+        static uint64_t read_varint(uint8_t const*& in) noexcept;
+        // Load 8 little-endian bytes, which is a single load on little-endian targets.
+        static uint64_t load64(uint8_t const* in) noexcept
+        {
+            uint64_t word = 0;
+            for (unsigned k = 0; k < 8; ++k) { word |= static_cast<uint64_t>(in[k]) << (8 * k); }
+            return word;
+        }
+        // Decode the block of count values at in, prev is the value before the block, return the end of the block.
+        static uint8_t const* decode_block(uint8_t const* in, size_t count, unsigned_type prev, T* out) noexcept;
+
+        std::vector<uint64_t> m_offsets;
+        std::vector<uint8_t> m_bytes;
+        size_t m_nelement = 0;
+
+    }; /* end class frozen_vector2d */
+
+    // Freeze the rows of a vector2d of integers into the compressed read-only form.
+    template <typename T, typename Allocator, typename Index>
+    frozen_vector2d<T> freeze(vector2d<T, Allocator, Index> const& rows)
+    {
+        return frozen_vector2d<T>(rows);
+    }
+
+    template <class T>
+    template <typename Allocator, typename Index>
+    frozen_vector2d<T>::frozen_vector2d(vector2d<T, Allocator, Index> const& rows)
+    {
+        m_offsets.reserve(rows.size() + 1);
+        m_offsets.push_back(0);
+        m_bytes.reserve(rows.nelement() + rows.size() + padding);
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            this->encode_row(rows.row_span(i));
+            m_offsets.push_back(m_bytes.size());
+        }
+        m_nelement = rows.nelement();
+        m_bytes.insert(m_bytes.end(), padding, uint8_t(0));
+        m_bytes.shrink_to_fit();
+    }
+
+    template <class T>
+    void frozen_vector2d<T>::encode_row(std::span<T const> row)
+    {
+        this->write_varint(row.size());
+
+        unsigned_type deltas[block_size];
+        unsigned_type prev = 0;
+        for (size_t first = 0; first < row.size(); first += block_size)
+        {
+            size_t const count = std::min(block_size, row.size() - first);
+
+            // The deltas of a non-decreasing block are stored as is, otherwise as zigzag.
+            bool sorted = row[first] >= static_cast<T>(prev);
+            for (size_t i = 1; sorted && i < count; ++i) { sorted = row[first + i] >= row[first + i - 1]; }
+
+            unsigned_type bits = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                unsigned_type const value = static_cast<unsigned_type>(row[first + i]);
+                unsigned_type delta = static_cast<unsigned_type>(value - prev);
+                if (!sorted)
+                {
+                    unsigned_type const sign = static_cast<unsigned_type>(0) - static_cast<unsigned_type>(delta >> (value_bits - 1));
+                    delta = static_cast<unsigned_type>(static_cast<unsigned_type>(delta << 1) ^ sign);
+                }
+                deltas[i] = delta;
+                bits |= delta;
+                prev = value;
+            }
+
+            unsigned const width = static_cast<unsigned>(std::bit_width(bits));
+            m_bytes.push_back(static_cast<uint8_t>(width | (sorted ? 0 : zigzag_flag)));
+
+            size_t const ibegin = m_bytes.size();
+            m_bytes.resize(ibegin + (count * width + 7) / 8, uint8_t(0));
+            uint8_t* out = m_bytes.data() + ibegin;
+            for (size_t i = 0, bit = 0; i < count; ++i, bit += width)
+            {
+                uint64_t const value = static_cast<uint64_t>(deltas[i]);
+                unsigned const shift = static_cast<unsigned>(bit & 7);
+                size_t const nbyte = (shift + width + 7) / 8;
+                for (size_t k = 0; k < nbyte; ++k)
+                {
+                    size_t const offset = 8 * k;
+                    out[(bit >> 3) + k] |= static_cast<uint8_t>(offset == 0 ? value << shift : value >> (offset - shift));
+                }
+            }
+        }
+    }
+
+    template <class T>
+    void frozen_vector2d<T>::write_varint(uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            m_bytes.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        m_bytes.push_back(static_cast<uint8_t>(value));
+    }
+
+    template <class T>
+    uint64_t frozen_vector2d<T>::read_varint(uint8_t const*& in) noexcept
+    {
+        uint64_t value = 0;
+        for (unsigned shift = 0;; shift += 7)
+        {
+            uint8_t const byte = *in++;
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (byte < 0x80) { return value; }
+        }
+    }
+
+    template <class T>
+    uint8_t const* frozen_vector2d<T>::decode_block(uint8_t const* in, size_t count, unsigned_type prev, T* out) noexcept
+    {
+        uint8_t const header = *in++;
+        unsigned const width = header & ~zigzag_flag;
+        uint64_t const mask = width == 64 ? ~uint64_t(0) : (uint64_t(1) << width) - 1;
+        // Each value is funnel shifted from the 8 bytes at its first byte and the ninth byte, which is shifted out
+        // when shift is 0 and masked when the value ends within the 8 bytes, so no value takes a branch.
+
+        if (header & zigzag_flag)
+        {
+            for (size_t i = 0, bit = 0; i < count; ++i, bit += width)
+            {
+                unsigned const shift = static_cast<unsigned>(bit & 7);
+                uint64_t value = load64(in + (bit >> 3)) >> shift;
+                value |= (static_cast<uint64_t>(in[(bit >> 3) + 8]) << 1) << (63 - shift);
+                unsigned_type const zigzag = static_cast<unsigned_type>(value & mask);
+                unsigned_type const delta = static_cast<unsigned_type>((zigzag >> 1) ^ (static_cast<unsigned_type>(0) - (zigzag & 1)));
+                prev = static_cast<unsigned_type>(prev + delta);
+                out[i] = static_cast<T>(prev);
+            }
+        }
+        else
+        {
+            for (size_t i = 0, bit = 0; i < count; ++i, bit += width)
+            {
+                unsigned const shift = static_cast<unsigned>(bit & 7);
+                uint64_t value = load64(in + (bit >> 3)) >> shift;
+                value |= (static_cast<uint64_t>(in[(bit >> 3) + 8]) << 1) << (63 - shift);
+                prev = static_cast<unsigned_type>(prev + static_cast<unsigned_type>(value & mask));
+                out[i] = static_cast<T>(prev);
+            }
+        }
+        return in + (count * width + 7) / 8;
+    }
+
+    template <class T>
+    size_t frozen_vector2d<T>::decode(size_t index, T* out) const
+    {
+        uint8_t const* in = m_bytes.data() + m_offsets[index];
+        size_t const size = static_cast<size_t>(read_varint(in));
+
+        unsigned_type prev = 0;
+        for (size_t first = 0; first < size; first += block_size)
+        {
+            size_t const count = std::min(block_size, size - first);
+            in = decode_block(in, count, prev, out + first);
+            prev = static_cast<unsigned_type>(out[first + count - 1]);
+        }
+        return size;
+    }
+
+    template <class T>
+    template <class F>
+    void frozen_vector2d<T>::for_each_block(size_t index, F&& fn) const
+    {
+        uint8_t const* in = m_bytes.data() + m_offsets[index];
+        size_t const size = static_cast<size_t>(read_varint(in));
+
+        T block[block_size];
+        unsigned_type prev = 0;
+        for (size_t first = 0; first < size; first += block_size)
+        {
+            size_t const count = std::min(block_size, size - first);
+            in = decode_block(in, count, prev, block);
+            prev = static_cast<unsigned_type>(block[count - 1]);
+            fn(std::span<T const>(block, count));
+        }
+    }
+
+    template <class T>
+    template <class F>
+    void frozen_vector2d<T>::for_each_row(F&& fn) const
+    {
+        std::vector<T> row;
+        for (size_t i = 0; i < this->size(); ++i)
+        {
+            row.resize(this->row_size(i));
+            this->decode(i, row.data());
+            fn(i, std::span<T const>(row));
+        }
+    }
+
+    template <class T>
+    template <typename Allocator>
+    vector2d<T, Allocator> frozen_vector2d<T>::to_vector2d(Allocator const& alloc) const
+    {
+        if (this->empty()) { return vector2d<T, Allocator>(alloc); }
+
+        std::vector<size_t> offsets(1, 0);
+        offsets.reserve(this->size() + 1);
+        for (size_t i = 0; i < this->size(); ++i) { offsets.push_back(offsets.back() + this->row_size(i)); }
+
+        typename vector2d<T, Allocator>::data_type values(m_nelement, T(), alloc);
+        for (size_t i = 0; i < this->size(); ++i) { this->decode(i, values.data() + offsets[i]); }
+        return vector2d<T, Allocator>(offsets, std::move(values));
+    }
+
+}  // namespace ollib
@@ -1,4 +1,13 @@
+#include "concurrent_vector2d.h"
+#include "fixed_vector2d.h"
+#include "frozen_vector2d.h"
+#include "sharded_vector2d.h"
 #include "vector2d.h"
+#include "vector2d_algorithm.h"
+#include "vector2d_loader.h"
+
+#include <string>
+#include <thread>
 
 using namespace std;
 
@@ -18,6 +27,16 @@ int main()
     v0[3].resize(6);
     v0.print();
 
+    // test vector2d::compact_step
+    while (!v0.compact_step(size_t(4))) {}
+    v0[1].push_back(-2);
+    v0.compact_step(std::chrono::steady_clock::now() + std::chrono::milliseconds(1));
+    v0.print();
+
+    // test vector2d::compact in place
+    v0.compact(vector2d<double>::compact_mode::in_place);
+    v0.print();
+
     // test nrow constructor.
     vector2d<double> v(5);
 
@@ -80,5 +99,152 @@ int main()
      
     v.print();
 
+    // test vector2d CSR construction and export
+    vector2d<double> v2(std::vector<size_t>{ 0, 2, 2, 5 }, std::vector<double>{ 1, 2, 3, 4, 5 });
+    v2[1].push_back(6);
+    auto csr = std::move(v2).export_csr();
+    vector2d<double> v3 = vector2d<double>::from_csr(csr.offsets.begin(), csr.offsets.end(), csr.values.begin());
+    v3.print();
+
+    // test vector2d::emplace_back and vector2d::row_type::emplace
+    vector2d<std::string> vs;
+    vs.emplace_back("a", "b");
+    vs.push_back(std::vector<std::string>{ "c" });
+    vs[0].emplace_back(3, 'd');
+    vs[1].emplace(vs[1].begin(), "e");
+    vs.print();
+
+    // test std::pmr::vector2d
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::vector2d<double> vp(3, 2, &arena);
+    vp[1].push_back(7);
+    vp.print();
+
+    // test vector2d::growth_policy
+    vector2d<double> v1(vector2d<double>::growth_policy{ 1.5, 2, 16 });
+    v1.push_back({ 1, 2 });
+    v1.push_back({ 3, 4 });
+    for (int i = 0; i < 10; ++i) { v1[0].push_back(i); }
+    v1.print();
+
+    // test vector2d::row_span and vector2d_view
+    double sum = 0;
+    for (double x : v1.row_span(0)) { sum += x; }
+    std::cout << "sum of row 0: " << sum << std::endl;
+    auto const exported = v1.export_csr();
+    for (std::span<double const> row : exported.view()) { std::cout << row.size() << " "; }
+    std::cout << std::endl;
+
+    // test the compacted copy and vector2d::shared_copy
+    vector2d<double> v1_copy(v1, vector2d<double>::copy_mode::compacted);
+    auto const snapshot = v1.shared_copy();
+    v1[0].push_back(7);
+    std::cout << "garbage of copy: " << v1_copy.ngarbage() << " snapshot rows: " << snapshot->view().size()
+        << " row 0: " << snapshot->view()[0].size() << " of " << v1[0].size() << std::endl;
+
+    // test vector2d::parallel_for_each_row and parallel compact
+    thread_pool pool(4);
+    v1.parallel_for_each_row(pool, [](vector2d<double>::row_type row) { for (auto& x : row) { x *= 2; } });
+    v1.compact(pool);
+    v1.parallel_for_each_row(std::execution::par, [](vector2d<double>::row_type row) { for (auto& x : row) { x /= 2; } });
+    v1.compact(std::execution::par);
+    v1.print();
+
+    // test vector2d::append_rows and vector2d::insert of multiple rows
+    std::vector<std::vector<double>> batch{ { 1 }, { 2, 3 }, {} };
+    v0.append_rows(batch);
+    v0.insert(v0.begin() + 1, batch.begin(), batch.end());
+    v0.print();
+
+    // test vector2d::erase_rows_if and vector2d::erase_rows
+    v0.erase_rows_if([](vector2d<double>::const_row_type row) { return row.empty(); });
+    v0.erase_rows({ 0, 2 }, true);
+    v0.print();
+
+    // test vector2d::sort_rows, vector2d::swap_rows and vector2d::compact by order
+    v0.sort_rows([](vector2d<double>::const_row_type a, vector2d<double>::const_row_type b) { return a.size() > b.size(); });
+    v0.swap_rows(0, v0.size() - 1);
+    std::vector<size_t> order(v0.size());
+    std::iota(order.rbegin(), order.rend(), size_t(0));
+    v0.compact(order);
+    v0.print();
+
+    // test capacity hints and vector2d::reserve_rows
+    vector2d<double> vr(3, 1, 4);
+    for (auto row : vr) { row.push_back(5); }
+    vr.reserve_rows(std::vector<size_t>{ 2, 8, 2 });
+    vr.print();
+
+    // test vector2d::elements
+    double total = 0;
+    for (std::span<double const> run : std::as_const(v0).elements())
+    {
+        for (double x : run) { total += x; }
+    }
+    std::cout << "sum of v0: " << total << std::endl;
+
+    // test fixed_vector2d
+    fixed_vector2d<double, 3> points{ { 0, 0, 0 }, { 1, 2, 3 } };
+    points.push_back({ 4, 5, 6 });
+    for (std::span<double, 3> point : points) { std::cout << point[0] + point[1] + point[2] << " "; }
+    std::cout << std::endl;
+
+    // test frozen_vector2d
+    vector2d<uint32_t> ids;
+    ids.append_rows({ { 3, 5, 8, 13 }, {}, { 100000, 100001, 7 } });
+    frozen_vector2d<uint32_t> const frozen = freeze(ids);
+    std::cout << "frozen rows: " << frozen.size() << " bytes: " << frozen.nbyte() << " row 2: " << frozen[2][2] << std::endl;
+
+    // test vector2d::transpose
+    vector2d<uint32_t> edges;
+    edges.append_rows({ { 1, 2 }, { 2 }, { 0 } });
+    vector2d<uint32_t> const reverse = edges.transpose(pool, 3);
+    std::cout << "reverse rows: " << reverse.size() << " row 2: " << reverse[2][0] << " " << reverse[2][1] << std::endl;
+
+    // test sharded_vector2d
+    sharded_vector2d<uint32_t> sharded(4);
+    sharded.append_rows(pool, std::vector<std::vector<uint32_t>>{ { 1 }, { 2, 3 }, {}, { 4 }, { 5, 6, 7 } });
+    sharded[4].push_back(8);
+    sharded.compact(pool);
+    std::cout << "sharded rows: " << sharded.size() << " elements: " << sharded.nelement() << " row 4: " << sharded[4].size() << std::endl;
+
+    // test load_text
+    std::istringstream lines("1, 2, 3\n\n4\n");
+    vector2d<int> loaded = load_text<int>(lines, pool);
+    std::cout << "loaded rows: " << loaded.size() << " elements: " << loaded.nelement() << std::endl;
+
+    // test the row kernels
+    std::vector<double> sums(loaded.size());
+    std::vector<size_t> counts(loaded.size());
+    transform_rows(pool, loaded, [](int x) { return x * 2; });
+    row_sum(pool, loaded, sums);
+    row_count_if(loaded, [](int x) { return x > 2; }, counts);
+    std::cout << "row sums: " << sums[0] << " " << sums[1] << " " << sums[2] << " counts: " << counts[0] << std::endl;
+
+    // test the set operations of sorted rows
+    vector2d<uint32_t> lists;
+    lists.append_rows({ { 1, 3, 5, 7, 9 }, { 3, 4, 5, 9 }, { 0, 5, 9 } });
+    std::vector<uint32_t> common(lists[2].size());
+    size_t const ncommon = intersect_rows(lists, { 0, 1, 2 }, common);
+    vector2d<uint32_t> postings(1);
+    append_union(postings[0], lists, { 0, 1, 2 });
+    std::cout << "common: " << ncommon << " union: " << postings[0].size() << std::endl;
+
+    // test the narrow index type
+    vector2d<uint32_t, std::allocator<uint32_t>, uint32_t> narrow;
+    narrow.append_rows({ { 1, 2 }, { 3 } });
+    narrow[1].push_back(4);
+    std::cout << "narrow rows: " << narrow.size() << " max index: " << narrow.max_index << " row 1: " << narrow[1][1] << std::endl;
+
+    // test concurrent_vector2d
+    concurrent_vector2d<int> vc;
+    std::vector<std::thread> producers;
+    for (int t = 0; t < 4; ++t)
+    {
+        producers.emplace_back([&vc, t] { for (int i = 0; i < 100; ++i) { vc.push_back({ t, i }); } });
+    }
+    for (auto& producer : producers) { producer.join(); }
+    std::cout << "concurrent rows: " << vc.size() << " elements: " << vc.to_vector2d().nelement() << std::endl;
+
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,335 @@
+#pragma once
+
+#include "vector2d.h"
+
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace std
+{
+
+    /**
+     * The read-only vector2d which maps a file written by vector2d::save().
+     *
+     * The rows are served from the mapped memory without parsing or copying, so opening a file
+     * costs O(1) regardless of its size, and the pages are loaded by the OS on first access.
+     *
+     * By default only the header and the first and the last offsets are checked on opening, and at()
+     * checks the offsets of its row, while operator[] trusts the file. validation::offsets checks that
+     * all the offsets are ascending on opening in O(n), so that operator[] is safe on a corrupted file.
+     */
+    template <typename T>
+    class mapped_vector2d
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "mapped_vector2d requires trivially copyable elements");
+
+    public:
+
+        /**
+         * The row of mapped_vector2d, which refers to the mapped memory.
+         */
+        class row_type
+        {
+
+        public:
+
+            row_type(T const* data, size_t size) : m_data(data), m_size(size) {}
+
+            // Iterators
+            using iterator = T const*;
+            using const_iterator = T const*;
+            const_iterator begin() const noexcept { return m_data; }
+            const_iterator end() const noexcept { return m_data + m_size; }
+            const_iterator cbegin() const noexcept { return m_data; }
+            const_iterator cend() const noexcept { return m_data + m_size; }
+
+            // Element access
+            T const& at(size_t index) const
+            {
+                if (index >= m_size)
+                {
+                    std::ostringstream ms;
+                    ms << "ollib::mapped_vector2d::row_type::at(): input index " << index << " is out of range.";
+                    throw std::out_of_range(ms.str());
+                }
+                return m_data[index];
+            }
+            T const& operator[](size_t index) const { return m_data[index]; }
+            T const& front() const { return m_data[0]; }
+            T const& back() const { return m_data[m_size - 1]; }
+            T const* data() const noexcept { return m_data; }
+            std::span<T const> as_span() const noexcept { return std::span<T const>(m_data, m_size); }
+
+            // Capacity
+            size_t size() const noexcept { return m_size; }
+            bool empty() const noexcept { return m_size == 0; }
+
+        private:
+
+            T const* m_data = nullptr;
+            size_t m_size = 0;
+
+        }; /* end class row_type */
+
+        // The checks of the file on opening.
+        enum class validation { header, offsets };
+
+        explicit mapped_vector2d(std::string const& path, validation mode = validation::header);
+        ~mapped_vector2d() { this->unmap(); }
+
+        mapped_vector2d(mapped_vector2d const&) = delete;
+        mapped_vector2d& operator=(mapped_vector2d const&) = delete;
+        mapped_vector2d(mapped_vector2d&& other) noexcept { this->swap(other); }
+        mapped_vector2d& operator=(mapped_vector2d&& other) noexcept
+        {
+            if (this != &other)
+            {
+                this->unmap();
+                this->swap(other);
+            }
+            return *this;
+        }
+
+        // Element access
+        row_type at(size_t index) const
+        {
+            if (index >= m_nrow)
+            {
+                std::ostringstream ms;
+                ms << "ollib::mapped_vector2d::at(): input index " << index << " is out of range.";
+                throw std::out_of_range(ms.str());
+            }
+            if (m_offsets[index] > m_offsets[index + 1] || m_offsets[index + 1] > m_offsets[m_nrow])
+            {
+                std::ostringstream ms;
+                ms << "ollib::mapped_vector2d::at(): row " << index << " has inconsistent offsets " << m_offsets[index] << ", "
+                    << m_offsets[index + 1] << ".";
+                throw std::runtime_error(ms.str());
+            }
+            return (*this)[index];
+        }
+        row_type operator[](size_t index) const
+        {
+            return row_type(m_values + m_offsets[index], static_cast<size_t>(m_offsets[index + 1] - m_offsets[index]));
+        }
+        row_type front() const { return (*this)[0]; }
+        row_type back() const { return (*this)[m_nrow - 1]; }
+        std::span<T const> row_span(size_t index) const { return (*this)[index].as_span(); }
+
+        // Capacity
+        size_t size() const noexcept { return m_nrow; }
+        bool empty() const noexcept { return m_nrow == 0; }
+        size_t nelement() const noexcept { return m_nrow == 0 ? 0 : static_cast<size_t>(m_offsets[m_nrow]); }
+
+        // The offsets (size() + 1 elements) and the values in the mapped memory.
+        uint64_t const* offsets() const noexcept { return m_offsets; }
+        T const* values() const noexcept { return m_values; }
+
+        // The view of the mapped rows, which is valid while this object is alive.
+        vector2d_view<T const, uint64_t> view() const noexcept { return vector2d_view<T const, uint64_t>(m_offsets, m_nrow, m_values); }
+
+        // Copy the rows into a vector2d.
+        template <typename Allocator = std::allocator<T>>
+        vector2d<T, Allocator> to_vector2d(Allocator const& alloc = Allocator()) const
+        {
+            if (m_nrow == 0) { return vector2d<T, Allocator>(alloc); }
+            return vector2d<T, Allocator>::from_csr(m_offsets, m_offsets + m_nrow + 1, m_values, alloc);
+        }
+
+        void swap(mapped_vector2d& other) noexcept
+        {
+            std::swap(m_address, other.m_address);
+            std::swap(m_length, other.m_length);
+#ifdef _WIN32
+            std::swap(m_file, other.m_file);
+            std::swap(m_mapping, other.m_mapping);
+#endif
+            std::swap(m_offsets, other.m_offsets);
+            std::swap(m_values, other.m_values);
+            std::swap(m_nrow, other.m_nrow);
+        }
+
+    private:
+
+        void map(std::string const& path);
+        void unmap() noexcept;
+        void validate(std::string const& path, validation mode);
+
+        [[noreturn]] static void fail(std::string const& path, char const* reason)
+        {
+            std::ostringstream ms;
+            ms << "ollib::mapped_vector2d(): " << path << " " << reason << ".";
+            throw std::runtime_error(ms.str());
+        }
+
+        void const* m_address = nullptr;
+        size_t m_length = 0;
+#ifdef _WIN32
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+#endif
+
+        uint64_t const* m_offsets = nullptr;
+        T const* m_values = nullptr;
+        size_t m_nrow = 0;
+
+    }; /* end class mapped_vector2d */
+
+    template <class T>
+    mapped_vector2d<T>::mapped_vector2d(std::string const& path, validation mode)
+    {
+        this->map(path);
+        try
+        {
+            this->validate(path, mode);
+        }
+        catch (...)
+        {
+            this->unmap();
+            throw;
+        }
+    }
+
+#ifdef _WIN32
+    template <class T>
+    void mapped_vector2d<T>::map(std::string const& path)
+    {
+        m_file = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (m_file == INVALID_HANDLE_VALUE) { fail(path, "cannot be opened"); }
+
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(m_file, &size))
+        {
+            this->unmap();
+            fail(path, "cannot be read");
+        }
+        m_length = static_cast<size_t>(size.QuadPart);
+        if (m_length < sizeof(vector2d_file_header))
+        {
+            this->unmap();
+            fail(path, "is too small");
+        }
+
+        m_mapping = ::CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        m_address = m_mapping ? ::MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (m_address == nullptr)
+        {
+            this->unmap();
+            fail(path, "cannot be mapped");
+        }
+    }
+
+    template <class T>
+    void mapped_vector2d<T>::unmap() noexcept
+    {
+        if (m_address) { ::UnmapViewOfFile(m_address); }
+        if (m_mapping) { ::CloseHandle(m_mapping); }
+        if (m_file != INVALID_HANDLE_VALUE) { ::CloseHandle(m_file); }
+        m_address = nullptr;
+        m_mapping = nullptr;
+        m_file = INVALID_HANDLE_VALUE;
+        m_length = 0;
+    }
+#else
+    template <class T>
+    void mapped_vector2d<T>::map(std::string const& path)
+    {
+        int const fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { fail(path, "cannot be opened"); }
+
+        struct stat st;
+        if (::fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            fail(path, "cannot be read");
+        }
+        m_length = static_cast<size_t>(st.st_size);
+        if (m_length < sizeof(vector2d_file_header))
+        {
+            ::close(fd);
+            fail(path, "is too small");
+        }
+
+        void* address = ::mmap(nullptr, m_length, PROT_READ, MAP_SHARED, fd, 0);
+        // The mapping stays valid after the file is closed.
+        ::close(fd);
+        if (address == MAP_FAILED)
+        {
+            m_length = 0;
+            fail(path, "cannot be mapped");
+        }
+        m_address = address;
+    }
+
+    template <class T>
+    void mapped_vector2d<T>::unmap() noexcept
+    {
+        if (m_address) { ::munmap(const_cast<void*>(m_address), m_length); }
+        m_address = nullptr;
+        m_length = 0;
+    }
+#endif
+
+    /**
+     * The header and the first and the last offsets are checked, and all the offsets for validation::offsets,
+     * the values themselves are never parsed.
+     */
+    template <class T>
+    void mapped_vector2d<T>::validate(std::string const& path, validation mode)
+    {
+        char const* base = static_cast<char const*>(m_address);
+        vector2d_file_header header;
+        std::memcpy(&header, base, sizeof(header));
+
+        if (std::memcmp(header.magic, vector2d_file_header::magic_string, sizeof(header.magic)) != 0) { fail(path, "is not a vector2d file"); }
+        if (header.version != vector2d_file_header::current_version) { fail(path, "has an unsupported version"); }
+        if (header.byte_order != vector2d_file_header::native_byte_order) { fail(path, "has a different byte order"); }
+        if (header.value_size != sizeof(T)) { fail(path, "has a different value size"); }
+
+        uint64_t const length = m_length;
+        if (header.offsets_offset % alignof(uint64_t) != 0 || header.values_offset % alignof(T) != 0
+            || header.offsets_offset > length
+            || header.nrow >= (length - header.offsets_offset) / sizeof(uint64_t)
+            || header.offsets_offset + (header.nrow + 1) * sizeof(uint64_t) > header.values_offset
+            || header.values_offset > length
+            || header.nelement > (length - header.values_offset) / sizeof(T))
+        {
+            fail(path, "is truncated or corrupted");
+        }
+
+        m_offsets = reinterpret_cast<uint64_t const*>(base + header.offsets_offset);
+        m_values = reinterpret_cast<T const*>(base + header.values_offset);
+        m_nrow = static_cast<size_t>(header.nrow);
+
+        if (m_offsets[0] != 0 || m_offsets[m_nrow] != header.nelement) { fail(path, "has inconsistent offsets"); }
+        if (mode == validation::offsets)
+        {
+            for (size_t i = 0; i < m_nrow; ++i)
+            {
+                if (m_offsets[i] > m_offsets[i + 1]) { fail(path, "has inconsistent offsets"); }
+            }
+        }
+    }
+
+}  // namespace ollib
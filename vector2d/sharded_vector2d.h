@@ -0,0 +1,337 @@
+#pragma once
+
+#include "vector2d.h"
+
+#include <algorithm>
+#include <execution>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace std
+{
+
+    /**
+     * The rows of one table split across nshard independent vector2d shards, so that no single buffer
+     * holds every element. Row i lives in shard i % nshard at the local index i / nshard, which keeps the
+     * global random access O(1) and spreads the rows evenly. Each shard has its own buffer, free space and
+     * compaction, so a reallocation or a compaction only moves the elements of one shard.
+     *
+     * The shards could be taken by different threads at the same time, e.g. by parallel_for_each_shard(),
+     * which runs one shard per task. Since the buffer of a shard is first touched by the thread which grows
+     * it, building and compacting the shards by parallel_for_each_shard() keeps each buffer on the memory
+     * node of its thread. The constructor with one allocator per shard places the shards explicitly, e.g.
+     * by a std::pmr::memory_resource per memory node.
+     *
+     * Rows are appended and removed at the end only; inserting or erasing a row in the middle would move
+     * every following row to another shard. shard() is read-only, and the shards could be modified through
+     * for_each_shard() or parallel_for_each_shard(), which count the rows again afterwards. Rows appended or
+     * removed there have to keep the placement, i.e. every row i stays in shard i % nshard.
+     */
+    template <typename T, typename Allocator = std::allocator<T>, typename Index = size_t>
+    class sharded_vector2d
+    {
+
+    public:
+
+        using value_type = T;
+        using allocator_type = Allocator;
+        using shard_type = vector2d<T, Allocator, Index>;
+        using row_type = typename shard_type::row_type;
+        using const_row_type = typename shard_type::const_row_type;
+
+        /* begin construction methods */
+        explicit sharded_vector2d(size_t nshard, Allocator const& alloc = Allocator())
+            : sharded_vector2d(std::vector<Allocator>(nshard, alloc))
+        {}
+
+        // Construct allocs.size() shards, shard k allocates its rows and elements by allocs[k].
+        explicit sharded_vector2d(std::vector<Allocator> const& allocs)
+        {
+            if (allocs.empty())
+            {
+                std::ostringstream ms;
+                ms << "ollib::sharded_vector2d(): input nshard " << allocs.size() << " cannot be zero";
+                throw std::out_of_range(ms.str());
+            }
+            m_shards.reserve(allocs.size());
+            for (auto const& alloc : allocs) { m_shards.emplace_back(alloc); }
+        }
+        /* end construction methods */
+
+        // Shards
+        size_t nshard() const noexcept { return m_shards.size(); }
+        shard_type const& shard(size_t k) const { return m_shards.at(k); }
+
+        // The shard and the local index of row index in it, and the reverse mapping.
+        size_t shard_of(size_t index) const noexcept { return index % m_shards.size(); }
+        size_t local_index(size_t index) const noexcept { return index / m_shards.size(); }
+        size_t global_index(size_t k, size_t local) const noexcept { return local * m_shards.size() + k; }
+
+        /* begin vector-like methods */
+
+        // Element access, the rows are the proxies of their shards.
+        row_type operator[](size_t index) { return m_shards[this->shard_of(index)][this->local_index(index)]; }
+        const_row_type operator[](size_t index) const { return m_shards[this->shard_of(index)][this->local_index(index)]; }
+        row_type at(size_t index)
+        {
+            this->check_index(index, "at");
+            return (*this)[index];
+        }
+        const_row_type at(size_t index) const
+        {
+            this->check_index(index, "at");
+            return (*this)[index];
+        }
+        row_type front() { return (*this)[0]; }
+        const_row_type front() const { return (*this)[0]; }
+        row_type back() { return (*this)[this->size() - 1]; }
+        const_row_type back() const { return (*this)[this->size() - 1]; }
+        std::span<T> row_span(size_t index) { return m_shards[this->shard_of(index)].row_span(this->local_index(index)); }
+        std::span<T const> row_span(size_t index) const { return m_shards[this->shard_of(index)].row_span(this->local_index(index)); }
+
+        // Capacity
+        size_t size() const noexcept { return m_size; }
+        bool empty() const noexcept { return m_size == 0; }
+        size_t nelement() const noexcept { return this->sum([](shard_type const& shard) { return shard.nelement(); }); }
+        size_t ngarbage() const noexcept { return this->sum([](shard_type const& shard) { return shard.ngarbage(); }); }
+        // Reserve the rows of every shard for nrow rows in total.
+        void reserve(size_t nrow)
+        {
+            for (size_t k = 0; k < m_shards.size(); ++k) { m_shards[k].reserve(this->nrow_of(k, nrow)); }
+        }
+
+        // Modifiers
+        void clear()
+        {
+            for (auto& shard : m_shards) { shard.clear(); }
+            m_size = 0;
+        }
+
+        void push_back(std::initializer_list<T> const& arr)
+        {
+            m_shards[this->shard_of(m_size)].push_back(arr);
+            ++m_size;
+        }
+        void push_back(std::vector<T> const& arr)
+        {
+            m_shards[this->shard_of(m_size)].push_back(arr);
+            ++m_size;
+        }
+        void push_back(std::vector<T>&& arr)
+        {
+            m_shards[this->shard_of(m_size)].push_back(std::move(arr));
+            ++m_size;
+        }
+        template <class... Args>
+        void emplace_back(Args&&... args)
+        {
+            m_shards[this->shard_of(m_size)].emplace_back(std::forward<Args>(args)...);
+            ++m_size;
+        }
+
+        void pop_back()
+        {
+            m_shards[this->shard_of(m_size - 1)].pop_back();
+            --m_size;
+        }
+
+        void resize(size_t size)
+        {
+            for (size_t k = 0; k < m_shards.size(); ++k) { m_shards[k].resize(this->nrow_of(k, size)); }
+            m_size = size;
+        }
+
+        /**
+         * Append the rows of a random access range of ranges, e.g. std::vector<std::vector<T>>. Each shard
+         * appends its own rows by one batch, and the overload with a thread pool runs the shards concurrently.
+         *
+         * Time complexity: O(s + m), where s = number of shards, m = number of appended elements
+         */
+        template <class RowRange>
+        void append_rows(RowRange const& rows)
+        {
+            size_t const base = m_size;
+            for (size_t k = 0; k < m_shards.size(); ++k) { this->append_shard_rows(k, base, rows); }
+            m_size += std::size(rows);
+        }
+        template <class RowRange>
+        void append_rows(thread_pool& pool, RowRange const& rows)
+        {
+            // parallel_for_each_shard() counts the appended rows.
+            size_t const base = m_size;
+            this->parallel_for_each_shard(pool, [this, base, &rows](size_t k, shard_type&) { this->append_shard_rows(k, base, rows); });
+        }
+
+        void swap(sharded_vector2d& other) noexcept
+        {
+            m_shards.swap(other.m_shards);
+            std::swap(m_size, other.m_size);
+        }
+
+        /* end vector-like methods */
+
+        // Call fn(k, shard) for each shard, the rows are counted again after fn returns or throws.
+        template <class F>
+        void for_each_shard(F&& fn)
+        {
+            recount_scope const recount{ *this };
+            for (size_t k = 0; k < m_shards.size(); ++k) { fn(k, m_shards[k]); }
+        }
+        template <class F>
+        void for_each_shard(F&& fn) const
+        {
+            for (size_t k = 0; k < m_shards.size(); ++k) { fn(k, m_shards[k]); }
+        }
+
+        /**
+         * Call fn(k, shard) for each shard concurrently, one shard per task. fn could modify its shard in any way
+         * which keeps the placement of rows, since no other task touches it, and the rows are counted again after
+         * all tasks are done.
+         */
+        template <class F>
+        void parallel_for_each_shard(thread_pool& pool, F fn)
+        {
+            recount_scope const recount{ *this };
+            pool.parallel_for(m_shards.size(), [this, &fn](size_t k) { fn(k, m_shards[k]); });
+        }
+        template <class ExecutionPolicy, class F, typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+        void parallel_for_each_shard(ExecutionPolicy&& policy, F fn)
+        {
+            recount_scope const recount{ *this };
+            std::vector<size_t> shards(m_shards.size());
+            std::iota(shards.begin(), shards.end(), size_t(0));
+            std::for_each(std::forward<ExecutionPolicy>(policy), shards.begin(), shards.end(), [this, &fn](size_t k) { fn(k, m_shards[k]); });
+        }
+
+        // Call fn(row) for each row concurrently by shards, fn must not change the size or the capacity of any row.
+        template <class F>
+        void parallel_for_each_row(thread_pool& pool, F fn)
+        {
+            this->parallel_for_each_shard(pool, [&fn](size_t, shard_type& shard) { std::for_each(shard.begin(), shard.end(), fn); });
+        }
+        template <class ExecutionPolicy, class F, typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+        void parallel_for_each_row(ExecutionPolicy&& policy, F fn)
+        {
+            this->parallel_for_each_shard(std::forward<ExecutionPolicy>(policy),
+                [&fn](size_t, shard_type& shard) { std::for_each(shard.begin(), shard.end(), fn); });
+        }
+
+        // Compact every shard, the overloads with a thread pool or an execution policy compact the shards concurrently.
+        void compact()
+        {
+            for (auto& shard : m_shards) { shard.compact(); }
+        }
+        void compact(thread_pool& pool)
+        {
+            this->parallel_for_each_shard(pool, [](size_t, shard_type& shard) { shard.compact(); });
+        }
+        template <class ExecutionPolicy, typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+        void compact(ExecutionPolicy&& policy)
+        {
+            this->parallel_for_each_shard(std::forward<ExecutionPolicy>(policy), [](size_t, shard_type& shard) { shard.compact(); });
+        }
+
+        // Copy the rows in the global order into one compacted vector2d.
+        template <typename OutAllocator = Allocator, typename OutIndex = Index>
+        vector2d<T, OutAllocator, OutIndex> to_vector2d(OutAllocator const& alloc = OutAllocator()) const;
+
+    private:
+
+        void check_index(size_t index, char const* func) const
+        {
+            if (index >= this->size())
+            {
+                std::ostringstream ms;
+                ms << "ollib::sharded_vector2d::" << func << "(): input index " << index << " is out of range.";
+                throw std::out_of_range(ms.str());
+            }
+        }
+
+        // The number of rows of shard k when there are nrow rows in total.
+        size_t nrow_of(size_t k, size_t nrow) const noexcept
+        {
+            return nrow / m_shards.size() + (k < nrow % m_shards.size() ? 1 : 0);
+        }
+
+        template <class F>
+        size_t sum(F&& fn) const noexcept
+        {
+            size_t total = 0;
+            for (auto const& shard : m_shards) { total += fn(shard); }
+            return total;
+        }
+
+        // Count the rows of all shards on destruction, after the shards were given out for modification.
+        struct recount_scope
+        {
+            sharded_vector2d& self;
+            ~recount_scope() { self.m_size = self.sum([](shard_type const& shard) { return shard.size(); }); }
+        };
+
+        // Append the rows of shard k among rows, which follow the base existing rows.
+        template <class RowRange>
+        void append_shard_rows(size_t k, size_t base, RowRange const& rows);
+
+        std::vector<shard_type> m_shards;
+        // The number of rows of all shards, so that appending doesn't sum the shards.
+        size_t m_size = 0;
+
+    }; /* end class sharded_vector2d */
+
+    /**
+     * The rows of shard k are rows[r] for r = first, first + nshard, ..., which are referred to by pointers
+     * and appended by one append_rows() of the shard, i.e. one reservation of its buffer and its rows.
+     */
+    template <class T, class Allocator, class Index>
+    template <class RowRange>
+    void sharded_vector2d<T, Allocator, Index>::append_shard_rows(size_t k, size_t base, RowRange const& rows)
+    {
+        size_t const nshard = m_shards.size();
+        size_t const nrow = std::size(rows);
+        size_t const first = (k + nshard - base % nshard) % nshard;
+
+        // The range of elements of a row given by pointer.
+        using row_pointer = decltype(std::addressof(*std::begin(rows)));
+        struct row_reference
+        {
+            row_pointer row;
+            auto begin() const { return std::begin(*row); }
+            auto end() const { return std::end(*row); }
+            size_t size() const { return std::size(*row); }
+        };
+
+        std::vector<row_reference> refs;
+        refs.reserve(this->nrow_of(k, base + nrow) - m_shards[k].size());
+        for (size_t r = first; r < nrow; r += nshard) { refs.push_back(row_reference{ std::addressof(std::begin(rows)[r]) }); }
+        m_shards[k].append_rows(refs);
+    }
+
+    template <class T, class Allocator, class Index>
+    template <typename OutAllocator, typename OutIndex>
+    vector2d<T, OutAllocator, OutIndex> sharded_vector2d<T, Allocator, Index>::to_vector2d(OutAllocator const& alloc) const
+    {
+        size_t const nrow = this->size();
+        if (nrow == 0) { return vector2d<T, OutAllocator, OutIndex>(alloc); }
+
+        std::vector<size_t> offsets(1, 0);
+        offsets.reserve(nrow + 1);
+        for (size_t i = 0; i < nrow; ++i) { offsets.push_back(offsets.back() + (*this)[i].size()); }
+
+        typename vector2d<T, OutAllocator, OutIndex>::data_type values(alloc);
+        values.reserve(offsets.back());
+        for (size_t i = 0; i < nrow; ++i)
+        {
+            std::span<T const> const row = this->row_span(i);
+            values.insert(values.end(), row.begin(), row.end());
+        }
+        return vector2d<T, OutAllocator, OutIndex>(offsets, std::move(values));
+    }
+
+}  // namespace ollib
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace std
+{
+
+    /**
+     * The fixed set of worker threads shared by the parallel operations of vector2d.
+     *
+     * parallel_for() is run by the workers and by the calling thread together. A parallel_for() called
+     * from inside a task or a loop of the same pool runs inline on its thread, so the nested loops never
+     * wait for workers which are all blocked in nested calls.
+     */
+    class thread_pool
+    {
+
+    public:
+
+        // The pool has nthread - 1 workers, the calling thread of parallel_for() is the last one.
+        explicit thread_pool(size_t nthread = std::thread::hardware_concurrency())
+        {
+            nthread = std::max<size_t>(nthread, 1);
+            m_workers.reserve(nthread - 1);
+            for (size_t i = 1; i < nthread; ++i) { m_workers.emplace_back([this] { this->work(); }); }
+        }
+
+        ~thread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_stopped = true;
+            }
+            m_ready.notify_all();
+            for (auto& worker : m_workers) { worker.join(); }
+        }
+
+        thread_pool(thread_pool const&) = delete;
+        thread_pool& operator=(thread_pool const&) = delete;
+
+        // The number of threads which run parallel_for(), including the calling thread.
+        size_t size() const noexcept { return m_workers.size() + 1; }
+
+        /**
+         * Call fn(i) for each i in [0, count) and wait for all of them, the indices are taken one by one
+         * by the threads, so a chunk of work per index balances the load. The first exception thrown by
+         * fn is rethrown after all the taken indices are done. A nested call on a thread of this pool calls
+         * fn(i) in order on that thread and stops at the first exception.
+         */
+        template <class F>
+        void parallel_for(size_t count, F&& fn);
+
+        // Run the task on a worker, or on the calling thread if the pool has no worker.
+        void submit(std::function<void()> task)
+        {
+            if (m_workers.empty())
+            {
+                task();
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_tasks.push_back(std::move(task));
+            }
+            m_ready.notify_one();
+        }
+
+    private:
+
+        // The pool whose task or loop runs on the current thread, if any.
+        static thread_pool*& current() noexcept
+        {
+            static thread_local thread_pool* pool = nullptr;
+            return pool;
+        }
+
+        void work()
+        {
+            current() = this;
+            for (;;)
+            {
+                std::function<void()> task;
+                {
+                    std::unique_lock<std::mutex> lock(m_mutex);
+                    m_ready.wait(lock, [this] { return m_stopped || !m_tasks.empty(); });
+                    if (m_tasks.empty()) { return; }
+                    task = std::move(m_tasks.front());
+                    m_tasks.pop_front();
+                }
+                task();
+            }
+        }
+
+        std::vector<std::thread> m_workers;
+        std::deque<std::function<void()>> m_tasks;
+        std::mutex m_mutex;
+        std::condition_variable m_ready;
+        bool m_stopped = false;
+
+    }; /* end class thread_pool */
+
+    template <class F>
+    void thread_pool::parallel_for(size_t count, F&& fn)
+    {
+        if (count == 0) { return; }
+        if (current() == this)
+        {
+            for (size_t i = 0; i < count; ++i) { fn(i); }
+            return;
+        }
+
+        // The state is shared with the helper tasks, which may start after the loop is done.
+        struct loop_state
+        {
+            std::atomic<size_t> next{ 0 };
+            size_t done = 0;
+            std::exception_ptr error;
+            std::mutex mutex;
+            std::condition_variable finished;
+        };
+        auto state = std::make_shared<loop_state>();
+        size_t const total = count;
+
+        auto run = [state, total, &fn]
+        {
+            size_t ndone = 0;
+            std::exception_ptr error;
+            for (size_t i = state->next++; i < total; i = state->next++)
+            {
+                try
+                {
+                    if (!error) { fn(i); }
+                }
+                catch (...)
+                {
+                    error = std::current_exception();
+                }
+                ++ndone;
+            }
+            if (ndone == 0) { return; }
+
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (error && !state->error) { state->error = error; }
+            state->done += ndone;
+            if (state->done == total) { state->finished.notify_all(); }
+        };
+
+        size_t const nhelper = std::min(m_workers.size(), count - 1);
+        for (size_t i = 0; i < nhelper; ++i) { this->submit(run); }
+        thread_pool* const outer = std::exchange(current(), this);
+        run();
+        current() = outer;
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->finished.wait(lock, [&] { return state->done == total; });
+        if (state->error) { std::rethrow_exception(state->error); }
+    }
+
+}  // namespace ollib
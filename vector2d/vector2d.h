@@ -1,19 +1,134 @@
 #pragma once
 
 #include <assert.h>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <algorithm>
+#include <execution>
 #include <initializer_list>
+#include <fstream>
 #include <iostream>
 #include <array>
+#include <span>
 #include <sstream>
+#include <stdexcept>
+#include <type_traits>
 #include <iterator>
+#include <limits>
+#include <map>
+#include <memory_resource>
 #include <memory>
 #include <numeric>
+#include <set>
+#include <string>
+#include <utility>
 #include <vector>
 
+#include "thread_pool.h"
+#include "vector2d_view.h"
+
 namespace std
 {
 
+    /**
+     * The binary format of vector2d, which is the compacted layout of rows and elements:
+     *
+     * | header (64 bytes) | offsets (uint64_t[nrow + 1]) | padding | values (T[nelement]) |
+     *
+     * Row i holds values[offsets[i], offsets[i + 1]), and offsets[0] is 0. The offsets start right after
+     * the header, and the values start at values_offset, which is aligned to 64 bytes. All the fields are
+     * stored in the native byte order, which is checked by byte_order.
+     */
+    struct vector2d_file_header
+    {
+        static constexpr char const* magic_string = "VECTOR2D";
+        static constexpr uint32_t current_version = 1;
+        static constexpr uint32_t native_byte_order = 0x01020304;
+        static constexpr uint64_t alignment = 64;
+
+        char magic[8];
+        uint32_t version;
+        uint32_t byte_order;
+        uint64_t value_size;
+        uint64_t nrow;
+        uint64_t nelement;
+        uint64_t offsets_offset;
+        uint64_t values_offset;
+        uint64_t reserved;
+    };
+    static_assert(sizeof(vector2d_file_header) == 64, "vector2d_file_header should be 64 bytes");
+
+#ifdef VECTOR2D_ENABLE_STATS
+#define VECTOR2D_STATS(statement) statement
+#else
+#define VECTOR2D_STATS(statement)
+#endif
+
+    /**
+     * The statistics of a vector2d, which are only collected if VECTOR2D_ENABLE_STATS is defined before
+     * vector2d.h is included, otherwise vector2d keeps no counters at all.
+     */
+    struct vector2d_stats
+    {
+        // The operations which could relocate a row.
+        enum operation : size_t { push_back, insert, reserve, resize, noperation };
+        static constexpr char const* operation_names[noperation] = { "push_back", "insert", "reserve", "resize" };
+
+        // The rows moved to a new place and their elements, by operation.
+        std::array<size_t, noperation> relocations{};
+        std::array<size_t, noperation> relocated_elements{};
+        // The elements moved inside m_data, by relocations, by insertions and erasures inside rows and by in-place compaction.
+        size_t moved_elements = 0;
+        // The reallocations of m_data, the total bytes of the new buffers and the largest capacity in elements.
+        size_t reallocations = 0;
+        size_t reallocated_bytes = 0;
+        size_t max_capacity = 0;
+        // The runs of compaction, including the automatic ones and each compact_step(), and their total time.
+        size_t compactions = 0;
+        std::chrono::nanoseconds compaction_time{ 0 };
+
+        // Call fn(name, value) for each counter, e.g. to export them to a metrics system.
+        template <class F>
+        void for_each(F&& fn) const
+        {
+            for (size_t op = 0; op < noperation; ++op)
+            {
+                fn(std::string("relocations.") + operation_names[op], relocations[op]);
+                fn(std::string("relocated_elements.") + operation_names[op], relocated_elements[op]);
+            }
+            fn(std::string("moved_elements"), moved_elements);
+            fn(std::string("reallocations"), reallocations);
+            fn(std::string("reallocated_bytes"), reallocated_bytes);
+            fn(std::string("max_capacity"), max_capacity);
+            fn(std::string("compactions"), compactions);
+            fn(std::string("compaction_time_ns"), static_cast<size_t>(compaction_time.count()));
+        }
+
+        // Count a compaction and its time from construction to destruction.
+        class compaction_scope
+        {
+
+        public:
+
+            explicit compaction_scope(vector2d_stats& stats, bool active = true)
+                : m_stats(stats), m_active(active), m_start(std::chrono::steady_clock::now()) {}
+            ~compaction_scope()
+            {
+                if (!m_active) { return; }
+                ++m_stats.compactions;
+                m_stats.compaction_time += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - m_start);
+            }
+
+        private:
+
+            vector2d_stats& m_stats;
+            bool m_active;
+            std::chrono::steady_clock::time_point m_start;
+
+        }; /* end class compaction_scope */
+    };
+
     /**
      * std::vector<std::vector<T>> is rather inefficient because each of the inner vectors
      * contains separately allocated heap memory.
@@ -22,102 +137,178 @@ namespace std
      * of nested std::vector, which stores its elements contiguously in a vector, and provides
      * interfaces like std::vector for the runtime-resizability.
      *
-     * It has O(1) constant time complexity of random access, and it will return row_type and
-     * row_type iterator (std::vector<row_type>::iterator) when we access or iterate it.
+     * It has O(1) constant time complexity of random access, and it will return the row_type proxy
+     * and row_iterator when we access or iterate it.
+     *
+     * Both the rows and the elements are allocated by Allocator, and std::pmr::vector2d<T> takes
+     * a std::pmr::memory_resource for them.
+     *
+     * The begin index, the size and the capacity of each row are stored as Index, so a narrower Index
+     * like uint32_t shrinks the metadata of a row from 24 to 12 bytes. Then m_data can't grow beyond
+     * max_index elements, including the holes and the spare capacity of rows, and any operation which
+     * would grow it further throws std::length_error before changing the container.
      */
-    template <typename T>
+    template <typename T, typename Allocator = std::allocator<T>, typename Index = size_t>
     class vector2d
     {
+        static_assert(std::is_integral<Index>::value && std::is_unsigned<Index>::value && sizeof(Index) <= sizeof(size_t),
+            "vector2d requires an unsigned integral Index no wider than size_t");
 
     public:
 
+        using allocator_type = Allocator;
+        using data_type = std::vector<T, Allocator>;
+        using index_type = Index;
+
+        // The largest size of m_data, i.e. the total number of elements, holes and spare capacity.
+        static constexpr size_t max_index = std::numeric_limits<Index>::max();
+
         /**
-         * The inner vector of vector2d is represented by row_type class.
-         * It shouldn't be used without vector2d.
+         * The growth policy of a row which runs out of capacity. The new capacity is the larger one of
+         * the required size and factor * capacity, and the slack beyond the required size is bounded by
+         * [min_slack, max_slack]. The default makes the amortized push_back O(1) like std::vector, and
+         * { 1.0, 0, 0 } only grows to the required size.
          */
-        class row_type
+        struct growth_policy
         {
+            double factor = 2.0;
+            size_t min_slack = 0;
+            size_t max_slack = std::numeric_limits<size_t>::max();
 
-        public:
+            size_t next_capacity(size_t capacity, size_t required) const
+            {
+                double const scaled = static_cast<double>(capacity) * factor;
+                size_t const grown = scaled >= static_cast<double>(std::numeric_limits<size_t>::max())
+                    ? std::numeric_limits<size_t>::max() : static_cast<size_t>(scaled);
+                size_t const slack = std::min(std::max(grown, required) - required, max_slack);
+                size_t const limit = std::numeric_limits<size_t>::max() - required;
+                return required + std::min(std::max(slack, min_slack), limit);
+            }
+        };
+
+        /**
+         * The compaction policy of unused memory. compact() runs automatically after an operation that frees
+         * elements of m_data, e.g. erasing or shrinking rows, when the unused elements ngarbage() + nspare()
+         * exceed both garbage_ratio * (size of m_data) and min_garbage. So the spare capacity left by shrinking
+         * rows is reclaimed as well as the holes, and m_data stays bounded by the live elements. It invalidates
+         * the element iterators like a reallocation of m_data does. The default garbage_ratio 1.0 never compacts.
+         */
+        struct compaction_policy
+        {
+            double garbage_ratio = 1.0;
+            size_t min_garbage = 0;
+        };
+
+    private:
 
-            class ctor_passkey
+        // The metadata of a row in m_rows, the row owns the elements [begin_index, begin_index + capacity) of m_data.
+        // The indices fit in Index since m_data never grows beyond max_index, see check_growth().
+        // A row without capacity is kept at the begin index 0, so its iterators stay valid when the end of m_data
+        // is removed.
+        struct row_record
+        {
+            row_record() = default;
+            row_record(size_t ibegin, size_t size)
+                : m_begin_index(static_cast<Index>(size == 0 ? 0 : ibegin)), m_size(static_cast<Index>(size)), m_capacity(static_cast<Index>(size)) {}
+
+            Index m_begin_index = 0;
+            Index m_size = 0;
+            Index m_capacity = 0;
+
+            size_t begin_index() const noexcept { return m_begin_index; }
+            size_t end_index() const noexcept { return m_begin_index + m_size; }
+            size_t size() const noexcept { return m_size; }
+            size_t capacity() const noexcept { return m_capacity; }
+            bool empty() const noexcept { return m_size == 0; }
+
+            // Place the row at ibegin without any spare capacity.
+            void relayout(size_t ibegin)
+            {
+                m_begin_index = static_cast<Index>(m_size == 0 ? 0 : ibegin);
+                m_capacity = m_size;
+            }
+            // Place the row at ibegin with the capacity, which is at least the size.
+            void relayout(size_t ibegin, size_t capacity)
             {
-            private:
+                m_capacity = static_cast<Index>(std::max<size_t>(m_size, capacity));
+                m_begin_index = static_cast<Index>(m_capacity == 0 ? 0 : ibegin);
+            }
+        };
 
-                ctor_passkey() {}
-                friend vector2d;
-            };
+    public:
 
-            row_type() = delete;
-            row_type(vector2d* container, ctor_passkey const&)
-                : m_container(container)
-                , m_begin_index(0)
-                , m_size(0)
-                , m_capacity(0)
-            {}
-            row_type(vector2d* container, size_t size, ctor_passkey const&)
-                : m_container(container)
-                , m_begin_index(0)
-                , m_size(size)
-                , m_capacity(size)
-            {}
-            row_type(vector2d* container, size_t istart, size_t size, ctor_passkey const&)
+        class const_row_type;
+
+        /**
+         * The inner vector of vector2d is represented by row_type class, which is the lightweight proxy of
+         * a row bound to its container. It's returned by value, and it's invalidated like a reference to
+         * the row, i.e. by inserting or erasing rows. It shouldn't be used without vector2d.
+         */
+        class row_type
+        {
+
+        public:
+
+            row_type(vector2d* container, row_record* record) noexcept
                 : m_container(container)
-                , m_begin_index(istart)
-                , m_size(size)
-                , m_capacity(size)
+                , m_record(record)
             {}
 
-            size_t begin_index() const { return m_begin_index; }
-            size_t end_index() const { return m_begin_index + m_size; }
+            size_t begin_index() const { return m_record->m_begin_index; }
+            size_t end_index() const { return m_record->m_begin_index + m_record->m_size; }
 
             /* begin vector-like methods */
 
             // Iterators
-            using iterator = typename std::vector<T>::iterator;
-            using const_iterator = typename std::vector<T>::const_iterator;
-            iterator begin() noexcept { return m_container->m_data.begin() + m_begin_index; }
-            iterator end() noexcept { return m_container->m_data.begin() + m_begin_index + m_size; }
-            const_iterator begin() const noexcept { return m_container->m_data.begin() + m_begin_index; }
-            const_iterator end() const noexcept { return m_container->m_data.begin() + m_begin_index + m_size; }
-            const_iterator cbegin() const noexcept { return m_container->m_data.begin() + m_begin_index; }
-            const_iterator cend() const noexcept { return m_container->m_data.begin() + m_begin_index + m_size; }
+            using iterator = typename data_type::iterator;
+            using const_iterator = typename data_type::const_iterator;
+            iterator begin() const noexcept { return m_container->m_data.begin() + this->begin_index(); }
+            iterator end() const noexcept { return m_container->m_data.begin() + this->end_index(); }
+            const_iterator cbegin() const noexcept { return m_container->m_data.cbegin() + this->begin_index(); }
+            const_iterator cend() const noexcept { return m_container->m_data.cbegin() + this->end_index(); }
 
             // Element access
-            T& at(size_t index) { return m_container->m_data.at(m_begin_index + index); }
-            T const& at(size_t index) const { return m_container->m_data.at(m_begin_index + index); }
-            T& operator[](size_t index) { return m_container->m_data[m_begin_index + index]; }
-            T const& operator[](size_t index) const { return m_container->m_data[m_begin_index + index]; }
-            T& front() { return m_container->m_data.at(m_begin_index); }
-            T const& front() const { return m_container->m_data.at(m_begin_index); }
-            T& back() { return m_container->m_data.at(m_begin_index + m_size - 1); }
-            T const& back() const { return m_container->m_data.at(m_begin_index + m_size - 1); }
+            T& at(size_t index) const { return m_container->m_data.at(this->begin_index() + index); }
+            T& operator[](size_t index) const { return m_container->m_data[this->begin_index() + index]; }
+            T& front() const { return m_container->m_data.at(this->begin_index()); }
+            T& back() const { return m_container->m_data.at(this->end_index() - 1); }
+            T* data() const noexcept { return m_container->m_data.data() + this->begin_index(); }
+
+            // The contiguous elements of row, which is valid until the row or m_data is reallocated.
+            std::span<T> as_span() const noexcept { return std::span<T>(this->data(), this->size()); }
 
             // Capacity
-            size_t size() const noexcept { return m_size; }
-            size_t max_size() const noexcept { return m_container->m_data.max_size(); }
-            bool empty() const { return m_size == 0; }
-            size_t capacity() const noexcept { return m_capacity; }
+            size_t size() const noexcept { return m_record->m_size; }
+            size_t max_size() const noexcept { return std::min(m_container->m_data.max_size(), max_index); }
+            bool empty() const { return m_record->m_size == 0; }
+            size_t capacity() const noexcept { return m_record->m_capacity; }
             void reserve(size_t size);
-            void shrink_to_fit() { m_capacity = m_size; }
+            void shrink_to_fit()
+            {
+                // Give the unused capacity back to the free space of container.
+                m_container->deallocate(this->end_index(), m_record->m_capacity - m_record->m_size);
+                m_record->relayout(m_record->begin_index());
+                m_container->auto_compact();
+            }
 
             // Modifiers
             void clear()
             {
-                if (this->empty()) { return; }
-                m_size = 0;
-                // Destruct elements in this row.
-                for (auto it = this->begin(); it != this->end(); ++it) { m_container->destroy(*it); }
+                m_container->clear_row(*m_record);
+                m_container->auto_compact();
             }
 
+            // The range could be given by std::move_iterator to move the elements.
             template <class InputIt>
             iterator insert(const_iterator pos, InputIt first, InputIt last);
-            iterator insert(iterator pos, const T& value);
+            iterator insert(const_iterator pos, const T& value);
+            iterator insert(const_iterator pos, T&& value);
 
             iterator erase(const_iterator first, const_iterator last);
             iterator erase(const_iterator pos);
 
             void push_back(T const& value);
+            void push_back(T&& value);
 
             void pop_back()
             {
@@ -125,41 +316,168 @@ namespace std
                 m_container->destroy(*(this->end() - 1));
                 // Reduce the size but keep the capacity as before.
                 this->update(this->begin_index(), this->size() - 1);
+                m_container->auto_compact();
             }
 
             void resize(size_t size) { this->resize(size, T()); }
 
             void resize(size_t size, T const& value);
 
+            template <class... Args> iterator emplace(const_iterator pos, Args&&... args);
+            template <class... Args> void emplace_back(Args&&... args);
+
             // TODO: implement the following interfaces if needed.
-            // template <class... Args> iterator emplace(const_iterator pos, Args &&... args);
-            // template <class... Args> void emplace_back(Args &&... args);
-            // void shrink_to_fit();
             // void swap(std::vector<T> & other);
 
             /* end vector-like methods */
 
+        private:
+
+            friend vector2d;
+            friend const_row_type;
+
             void update(size_t ibegin, size_t size)
             {
-                m_begin_index = ibegin;
-                m_size = size;
-                m_capacity = std::max(m_size, m_capacity);
+                m_container->m_nelement += size - m_record->m_size;
+                m_record->m_size = static_cast<Index>(size);
+                m_record->relayout(ibegin, m_record->m_capacity);
+            }
+
+            // Make sure the capacity is at least the given size, the row grows in place when it's at the end of
+            // m_data or followed by a hole, otherwise it's relocated to a hole or to the end of m_data.
+            void grow(size_t capacity, vector2d_stats::operation op);
+
+            // Grow the capacity by the growth policy of container if the size doesn't fit. The slack is limited to
+            // the space left for the index type, so that a size which fits never throws for the slack.
+            void expand(size_t size, vector2d_stats::operation op)
+            {
+                if (size <= m_record->m_capacity) { return; }
+                size_t const capacity = m_container->m_growth.next_capacity(m_record->m_capacity, size);
+                this->grow(std::max(size, std::min(capacity, max_index - m_container->m_data.size())), op);
+            }
+
+            vector2d* m_container;
+            row_record* m_record;
+
+        }; /* end class row_type */
+
+        /**
+         * The read-only proxy of a row, which is returned by the const methods of vector2d.
+         */
+        class const_row_type
+        {
+
+        public:
+
+            const_row_type(vector2d const* container, row_record const* record) noexcept
+                : m_container(container)
+                , m_record(record)
+            {}
+            const_row_type(row_type const& row) noexcept
+                : m_container(row.m_container)
+                , m_record(row.m_record)
+            {}
+
+            size_t begin_index() const { return m_record->m_begin_index; }
+            size_t end_index() const { return m_record->m_begin_index + m_record->m_size; }
+
+            // Iterators
+            using iterator = typename data_type::const_iterator;
+            using const_iterator = typename data_type::const_iterator;
+            const_iterator begin() const noexcept { return m_container->m_data.begin() + this->begin_index(); }
+            const_iterator end() const noexcept { return m_container->m_data.begin() + this->end_index(); }
+            const_iterator cbegin() const noexcept { return this->begin(); }
+            const_iterator cend() const noexcept { return this->end(); }
+
+            // Element access
+            T const& at(size_t index) const { return m_container->m_data.at(this->begin_index() + index); }
+            T const& operator[](size_t index) const { return m_container->m_data[this->begin_index() + index]; }
+            T const& front() const { return m_container->m_data.at(this->begin_index()); }
+            T const& back() const { return m_container->m_data.at(this->end_index() - 1); }
+            T const* data() const noexcept { return m_container->m_data.data() + this->begin_index(); }
+            std::span<T const> as_span() const noexcept { return std::span<T const>(this->data(), this->size()); }
+
+            // Capacity
+            size_t size() const noexcept { return m_record->m_size; }
+            size_t max_size() const noexcept { return std::min(m_container->m_data.max_size(), max_index); }
+            bool empty() const { return m_record->m_size == 0; }
+            size_t capacity() const noexcept { return m_record->m_capacity; }
+
+        private:
+
+            vector2d const* m_container;
+            row_record const* m_record;
+
+        }; /* end class const_row_type */
+
+        /**
+         * The random access iterator over the rows, which is dereferenced to the proxy Row by value.
+         */
+        template <class Row, class Container, class Record>
+        class basic_row_iterator
+        {
+
+        public:
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = Row;
+            using difference_type = std::ptrdiff_t;
+            using reference = Row;
+            // it->f() calls f on a temporary proxy.
+            struct pointer
+            {
+                Row row;
+                Row* operator->() { return &row; }
+            };
+
+            basic_row_iterator() = default;
+            basic_row_iterator(Container* container, Record* record) : m_container(container), m_record(record) {}
+            // The iterator converts to its const version.
+            operator basic_row_iterator<const_row_type, vector2d const, row_record const>() const
+            {
+                return basic_row_iterator<const_row_type, vector2d const, row_record const>(m_container, m_record);
             }
 
-            void reset(vector2d* container) { m_container = container; }
+            reference operator*() const { return Row(m_container, m_record); }
+            pointer operator->() const { return pointer{ Row(m_container, m_record) }; }
+            reference operator[](difference_type n) const { return Row(m_container, m_record + n); }
+
+            basic_row_iterator& operator++() { ++m_record; return *this; }
+            basic_row_iterator operator++(int) { basic_row_iterator old = *this; ++m_record; return old; }
+            basic_row_iterator& operator--() { --m_record; return *this; }
+            basic_row_iterator operator--(int) { basic_row_iterator old = *this; --m_record; return old; }
+            basic_row_iterator& operator+=(difference_type n) { m_record += n; return *this; }
+            basic_row_iterator& operator-=(difference_type n) { m_record -= n; return *this; }
+            basic_row_iterator operator+(difference_type n) const { return basic_row_iterator(m_container, m_record + n); }
+            basic_row_iterator operator-(difference_type n) const { return basic_row_iterator(m_container, m_record - n); }
+            friend basic_row_iterator operator+(difference_type n, basic_row_iterator const& it) { return it + n; }
+            difference_type operator-(basic_row_iterator const& other) const { return m_record - other.m_record; }
+
+            bool operator==(basic_row_iterator const& other) const { return m_record == other.m_record; }
+            bool operator!=(basic_row_iterator const& other) const { return m_record != other.m_record; }
+            bool operator<(basic_row_iterator const& other) const { return m_record < other.m_record; }
+            bool operator>(basic_row_iterator const& other) const { return m_record > other.m_record; }
+            bool operator<=(basic_row_iterator const& other) const { return m_record <= other.m_record; }
+            bool operator>=(basic_row_iterator const& other) const { return m_record >= other.m_record; }
 
         private:
 
-            vector2d* m_container = nullptr;
+            friend vector2d;
 
-            size_t m_begin_index = 0;
-            size_t m_size = 0;
-            size_t m_capacity = 0;
+            Container* m_container = nullptr;
+            Record* m_record = nullptr;
 
-        }; /* end class row_type */
+        }; /* end class basic_row_iterator */
+
+        using row_iterator = basic_row_iterator<row_type, vector2d, row_record>;
+        using const_row_iterator = basic_row_iterator<const_row_type, vector2d const, row_record const>;
+
+        using row_allocator_type = typename std::allocator_traits<Allocator>::template rebind_alloc<row_record>;
+        using rows_type = std::vector<row_record, row_allocator_type>;
 
         /* begin construction methods */
-        vector2d(const size_t& nrow)
+        vector2d(const size_t& nrow, Allocator const& alloc = Allocator())
+            : vector2d(alloc)
         {
             if (nrow == 0)
             {
@@ -167,10 +485,11 @@ namespace std
                 ms << "ollib::vector2d(): input nrow " << nrow << " cannot be zero";
                 throw std::out_of_range(ms.str());
             }
-            m_rows.assign(nrow, row_type(this, 0, 0, typename row_type::ctor_passkey()));
+            m_rows.assign(nrow, row_record());
         }
 
-        vector2d(const size_t& nrow, const size_t& ncol)
+        vector2d(const size_t& nrow, const size_t& ncol, Allocator const& alloc = Allocator())
+            : vector2d(alloc)
         {
             if (nrow == 0 || ncol == 0)
             {
@@ -178,61 +497,172 @@ namespace std
                 ms << "ollib::vector2d(): input nrow " << nrow << " or ncol " << ncol << " cannot be zero";
                 throw std::out_of_range(ms.str());
             }
+            this->check_growth(m_data.size(), nrow, ncol);
             m_rows.reserve(nrow);
-            m_data.reserve(nrow * ncol);
+            m_data.assign(nrow * ncol, T());
 
-            std::vector<T> columns(ncol);
-            for (size_t i = 0; i < nrow; ++i) { push_back(columns); }
+            for (size_t i = 0; i < nrow; ++i) { m_rows.emplace_back(i * ncol, ncol); }
+            m_nelement = nrow * ncol;
         }
-        /* end construction methods */
 
-        vector2d() = default;
-        vector2d(vector2d const& other)
+        /**
+         * Construct nrow rows of ncol elements, each row has the capacity max(ncol, capacity) so that it
+         * grows in place until the capacity is used up.
+         */
+        vector2d(const size_t& nrow, const size_t& ncol, const size_t& capacity, Allocator const& alloc = Allocator())
+            : vector2d(alloc)
         {
-            m_data = other.m_data;
-            m_rows = other.m_rows;
-            for (auto& row : m_rows) { row.reset(this); }
+            if (nrow == 0)
+            {
+                std::ostringstream ms;
+                ms << "ollib::vector2d(): input nrow " << nrow << " cannot be zero";
+                throw std::out_of_range(ms.str());
+            }
+            size_t const stride = std::max(ncol, capacity);
+            this->check_growth(m_data.size(), nrow, stride);
+            m_rows.reserve(nrow);
+            m_data.assign(nrow * stride, T());
+
+            for (size_t i = 0; i < nrow; ++i)
+            {
+                m_rows.emplace_back(i * stride, ncol);
+                m_rows.back().relayout(i * stride, stride);
+            }
+            m_nelement = nrow * ncol;
         }
-        vector2d(vector2d&& other)
+
+        // Construct capacities.size() empty rows, row i has the capacity capacities[i].
+        explicit vector2d(std::vector<size_t> const& capacities, Allocator const& alloc = Allocator())
+            : vector2d(alloc)
         {
-            m_data = std::move(other.m_data);
-            m_rows = std::move(other.m_rows);
-            for (auto& row : m_rows) { row.reset(this); }
+            m_rows.assign(capacities.size(), row_record());
+            this->reserve_rows(capacities);
+        }
+
+        /**
+         * Construct from the CSR (compressed sparse row) format, row i holds values[offsets[i], offsets[i + 1]).
+         * The values are taken as the buffer of elements without copying.
+         */
+        vector2d(std::vector<size_t> const& offsets, data_type&& values);
+
+        // Construct from nested vectors, the elements are moved with one reservation.
+        explicit vector2d(std::vector<std::vector<T>>&& rows, Allocator const& alloc = Allocator());
+
+        // Construct from the CSR format given by the offsets range and the begin of values.
+        template <class OffsetIt, class ValueIt>
+        static vector2d from_csr(OffsetIt offsets_first, OffsetIt offsets_last, ValueIt values_first,
+            Allocator const& alloc = Allocator());
+
+        explicit vector2d(growth_policy const& policy, Allocator const& alloc = Allocator())
+            : vector2d(alloc)
+        {
+            this->set_growth_policy(policy);
         }
+
+        // Both m_rows and m_data are allocated by alloc.
+        explicit vector2d(Allocator const& alloc)
+            : m_rows(row_allocator_type(alloc))
+            , m_data(alloc)
+            , m_holes(alloc)
+        {}
+        /* end construction methods */
+
+        vector2d() : vector2d(Allocator()) {}
+        vector2d(vector2d const& other)
+            : m_rows(other.m_rows)
+            , m_data(other.m_data)
+            , m_holes(other.m_holes)
+            , m_growth(other.m_growth)
+            , m_compaction(other.m_compaction)
+            , m_nelement(other.m_nelement)
+        {}
+        vector2d(vector2d const& other, Allocator const& alloc)
+            : m_rows(other.m_rows, row_allocator_type(alloc))
+            , m_data(other.m_data, alloc)
+            , m_holes(other.m_holes, alloc)
+            , m_growth(other.m_growth)
+            , m_compaction(other.m_compaction)
+            , m_nelement(other.m_nelement)
+        {}
+        // Only the buffers are moved, no row refers to its container.
+        vector2d(vector2d&& other) noexcept
+            : m_rows(std::move(other.m_rows))
+            , m_data(std::move(other.m_data))
+            , m_holes(std::move(other.m_holes))
+            , m_growth(other.m_growth)
+            , m_compaction(other.m_compaction)
+            , m_nelement(std::exchange(other.m_nelement, 0))
+        {}
+
+        /**
+         * The copy modes of vector2d(other, mode):
+         * exact: Copy m_data as is, including the holes and the spare capacity of rows, like the copy constructor.
+         * compacted: Copy only the elements of rows in the order of rows, so the copy has no garbage and no spare capacity.
+         */
+        enum class copy_mode { exact, compacted };
+
+        /**
+         * Both modes take the allocator by select_on_container_copy_construction() like the copy constructor.
+         *
+         * Time complexity: O(n + m), where n = number of rows, m = size of m_data for exact and number of elements for compacted
+         */
+        vector2d(vector2d const& other, copy_mode mode);
+
         vector2d& operator=(vector2d const& other)
         {
             m_data = other.m_data;
             m_rows = other.m_rows;
-            for (auto& row : m_rows) { row.reset(this); }
+            m_holes = other.m_holes;
+            m_growth = other.m_growth;
+            m_compaction = other.m_compaction;
+            m_nelement = other.m_nelement;
+            this->reset_compact_steps();
+            VECTOR2D_STATS(this->reset_stats());
+            return *this;
         }
-        vector2d& operator=(vector2d&& other)
+        // The buffers are moved as by std::vector, so the elements are moved one by one if the allocators differ and
+        // don't propagate, e.g. std::pmr::vector2d of different memory resources, which could throw.
+        vector2d& operator=(vector2d&& other) noexcept(std::allocator_traits<Allocator>::propagate_on_container_move_assignment::value
+            || std::allocator_traits<Allocator>::is_always_equal::value)
         {
             m_data = std::move(other.m_data);
             m_rows = std::move(other.m_rows);
-            for (auto& row : m_rows) { row.reset(this); }
+            m_holes = std::move(other.m_holes);
+            m_growth = other.m_growth;
+            m_compaction = other.m_compaction;
+            m_nelement = std::exchange(other.m_nelement, 0);
+            this->reset_compact_steps();
+            other.reset_compact_steps();
+            VECTOR2D_STATS(this->reset_stats());
+            return *this;
         }
 
         /* begin vector-like methods */
 
         // Iterators
-        using row_iterator = typename std::vector<row_type>::iterator;
-        using const_row_iterator = typename std::vector<row_type>::const_iterator;
-        row_iterator begin() noexcept { return m_rows.begin(); }
-        row_iterator end() noexcept { return m_rows.end(); }
-        const_row_iterator begin() const noexcept { return m_rows.begin(); }
-        const_row_iterator end() const noexcept { return m_rows.end(); }
-        const_row_iterator cbegin() const noexcept { return m_rows.begin(); }
-        const_row_iterator cend() const noexcept { return m_rows.end(); }
-
-        // Element access
-        row_type& at(size_t index) { return m_rows.at(index); }
-        row_type const& at(size_t index) const { return m_rows.at(index); }
-        row_type& operator[](size_t index) { return m_rows[index]; }
-        row_type const& operator[](size_t index) const { return m_rows[index]; }
-        row_type& front() { return m_rows.front(); }
-        row_type const& front() const { return m_rows.front(); }
-        row_type& back() { return m_rows.back(); }
-        row_type const& back() const { return m_rows.back(); }
+        row_iterator begin() noexcept { return row_iterator(this, m_rows.data()); }
+        row_iterator end() noexcept { return row_iterator(this, m_rows.data() + m_rows.size()); }
+        const_row_iterator begin() const noexcept { return const_row_iterator(this, m_rows.data()); }
+        const_row_iterator end() const noexcept { return const_row_iterator(this, m_rows.data() + m_rows.size()); }
+        const_row_iterator cbegin() const noexcept { return this->begin(); }
+        const_row_iterator cend() const noexcept { return this->end(); }
+
+        // Element access, the rows are returned as proxies by value.
+        row_type at(size_t index) { return row_type(this, &m_rows.at(index)); }
+        const_row_type at(size_t index) const { return const_row_type(this, &m_rows.at(index)); }
+        row_type operator[](size_t index) { return row_type(this, &m_rows[index]); }
+        const_row_type operator[](size_t index) const { return const_row_type(this, &m_rows[index]); }
+        row_type front() { return row_type(this, &m_rows.front()); }
+        const_row_type front() const { return const_row_type(this, &m_rows.front()); }
+        row_type back() { return row_type(this, &m_rows.back()); }
+        const_row_type back() const { return const_row_type(this, &m_rows.back()); }
+        std::span<T> row_span(size_t index) { return std::span<T>(m_data.data() + m_rows[index].begin_index(), m_rows[index].size()); }
+        std::span<T const> row_span(size_t index) const
+        {
+            return std::span<T const>(m_data.data() + m_rows[index].begin_index(), m_rows[index].size());
+        }
+
+        allocator_type get_allocator() const noexcept { return m_data.get_allocator(); }
 
         // Capacity
         size_t size() const noexcept { return m_rows.size(); }
@@ -241,145 +671,769 @@ namespace std
         size_t capacity() const noexcept { return m_rows.capacity(); }
         void reserve(size_t size) { m_rows.reserve(size); }
 
+        /**
+         * Make sure every row has at least the capacity, or row i has at least capacities[i]. A row with a larger
+         * capacity keeps it, so the capacity of a row never shrinks. All rows are laid out in the order of rows by
+         * one pass, which leaves no garbage, and the following push_back() of a row writes in place until its
+         * capacity is used up.
+         *
+         * Time complexity: O(n + m), where n = number of rows, m = total capacity
+         */
+        void reserve_rows(size_t capacity)
+        {
+            this->layout_rows([capacity](size_t) { return capacity; });
+        }
+        void reserve_rows(std::vector<size_t> const& capacities)
+        {
+            if (capacities.size() != m_rows.size())
+            {
+                std::ostringstream ms;
+                ms << "ollib::vector2d::reserve_rows(): input " << capacities.size() << " capacities don't match "
+                    << m_rows.size() << " rows.";
+                throw std::out_of_range(ms.str());
+            }
+            this->layout_rows([&capacities](size_t i) { return capacities[i]; });
+        }
+
         // Modifiers
         void clear()
         {
-            for (auto& row : m_rows) { row.clear(); }
+            // The elements are destroyed by m_data.
             m_data.clear();
             m_rows.clear();
+            m_holes.clear();
+            m_nelement = 0;
+        }
+
+        // Insert the rows of [first, last) before pos, each of which is a range of elements, e.g. row_type or std::vector<T>.
+        template <class ForwardIt>
+        row_iterator insert(const_row_iterator pos, ForwardIt first, ForwardIt last);
+        row_iterator insert(row_iterator pos, const_row_type row);
+
+        // Append the rows of a range of ranges, the elements are moved if rows is an rvalue.
+        template <class RowRange>
+        void append_rows(RowRange&& rows)
+        {
+            this->insert_rows<!std::is_lvalue_reference<RowRange>::value>(m_rows.size(), std::begin(rows), std::end(rows));
+        }
+        void append_rows(std::initializer_list<std::initializer_list<T>> rows)
+        {
+            this->insert_rows<false>(m_rows.size(), rows.begin(), rows.end());
         }
 
-        row_iterator insert(const_row_iterator pos, row_iterator first, row_iterator last);
-        row_iterator insert(row_iterator pos, row_type const& row);
+        // Replace all rows by the rows of a range of ranges, which must not refer to this vector2d.
+        template <class RowRange>
+        void assign_rows(RowRange&& rows)
+        {
+            this->clear();
+            this->append_rows(std::forward<RowRange>(rows));
+        }
+        void assign_rows(std::initializer_list<std::initializer_list<T>> rows)
+        {
+            this->clear();
+            this->append_rows(rows);
+        }
 
         row_iterator erase(const_row_iterator first, const_row_iterator last);
         row_iterator erase(const_row_iterator pos);
 
+        /**
+         * Erase the rows for which pred(row) returns true in one stable pass, return the number of
+         * erased rows. If compact_data is true, the surviving rows are moved into a compacted buffer
+         * in the same pass, otherwise the memory of erased rows is given back to the free space.
+         */
+        template <class Pred>
+        size_t erase_rows_if(Pred pred, bool compact_data = false)
+        {
+            return this->erase_rows_where([&pred](size_t, const_row_type row) { return static_cast<bool>(pred(row)); }, compact_data);
+        }
+        // Reorder the rows by comp(const_row_type, const_row_type), only m_rows is reordered and no element moves.
+        template <class Compare>
+        void sort_rows(Compare comp)
+        {
+            std::stable_sort(m_rows.begin(), m_rows.end(),
+                [this, &comp](row_record const& a, row_record const& b) { return comp(const_row_type(this, &a), const_row_type(this, &b)); });
+        }
+        // Reorder the rows so that row i is the old row perm[i], only m_rows is reordered.
+        void permute_rows(std::vector<size_t> const& perm)
+        {
+            this->check_permutation(perm, "permute_rows");
+            rows_type rows(m_rows.get_allocator());
+            rows.reserve(perm.size());
+            for (size_t i : perm) { rows.push_back(m_rows[i]); }
+            m_rows.swap(rows);
+        }
+        void swap_rows(size_t i, size_t j)
+        {
+            if (i >= m_rows.size() || j >= m_rows.size())
+            {
+                std::ostringstream ms;
+                ms << "ollib::vector2d::swap_rows(): input index " << std::max(i, j) << " is out of range.";
+                throw std::out_of_range(ms.str());
+            }
+            std::swap(m_rows[i], m_rows[j]);
+        }
+
+        // Erase the rows at the indices in any order, the duplicated indices are erased once.
+        template <class IndexRange>
+        size_t erase_rows(IndexRange const& indices, bool compact_data = false);
+        size_t erase_rows(std::initializer_list<size_t> indices, bool compact_data = false)
+        {
+            return this->erase_rows<std::initializer_list<size_t>>(indices, compact_data);
+        }
+
         void push_back(std::initializer_list<T> const& arr);
 
         void push_back(std::vector<T> const& arr);
 
+        void push_back(std::vector<T>&& arr);
+
         void pop_back()
         {
-            m_rows.back().clear();
+            this->release(m_rows.back());
             m_rows.pop_back();
+            this->auto_compact();
         }
 
         void resize(size_t size)
         {
+            // Give the memory of removed rows back to the free space.
+            for (size_t i = size; i < m_rows.size(); ++i) { this->release(m_rows[i]); }
             // Resize with empty Row.
-            m_rows.resize(size, row_type(this, typename row_type::ctor_passkey()));
+            m_rows.resize(size);
+            this->auto_compact();
         }
 
-        void resize(size_t size, row_type const& row);
+        void resize(size_t size, const_row_type row);
+
+        // Add a new row, each of args constructs one element of the row in place.
+        template <class... Args> row_iterator emplace(const_row_iterator pos, Args&&... args);
+        template <class... Args> void emplace_back(Args&&... args);
+
+        // Exchange the contents in O(1). As with std::vector, the allocators are exchanged if they propagate on swap,
+        // otherwise they have to be equal, e.g. std::pmr::vector2d of the same memory resource.
+        void swap(vector2d& other) noexcept(std::allocator_traits<Allocator>::propagate_on_container_swap::value
+            || std::allocator_traits<Allocator>::is_always_equal::value)
+        {
+            m_rows.swap(other.m_rows);
+            m_data.swap(other.m_data);
+            std::swap(m_holes, other.m_holes);
+            std::swap(m_growth, other.m_growth);
+            std::swap(m_compaction, other.m_compaction);
+            std::swap(m_nelement, other.m_nelement);
+            m_step_plan.swap(other.m_step_plan);
+            std::swap(m_step_next, other.m_step_next);
+            std::swap(m_step_frontier, other.m_step_frontier);
+#ifdef VECTOR2D_ENABLE_STATS
+            std::swap(m_stats, other.m_stats);
+#endif
+        }
 
         // TODO: implement the following interfaces if needed.
-        // template <class... Args> row_iterator emplace(const_row_iterator pos, Args &&... args);
-        // template <class... Args> void emplace_back(Args &&... args);
         // void shrink_to_fit();
-        // void swap(vector2d<T> & other);
 
         /* end vector-like methods */
 
-        size_t nelement()
+        /**
+         * The CSR format of vector2d, row i holds values[offsets[i], offsets[i + 1]) and offsets has size() + 1 elements.
+         */
+        struct csr_type
         {
-            auto acc_func = [](size_t accumulator, row_type const& r)
-            { return accumulator + r.size(); };
-            return std::accumulate(m_rows.begin(), m_rows.end(), 0, acc_func);
-        }
+            std::vector<size_t> offsets;
+            data_type values;
 
-        void compact()
-        {
-            std::vector<T> data;
-            data.reserve(nelement());
+            // The view of the exported rows, which is valid while offsets and values are not modified.
+            vector2d_view<T> view() noexcept { return vector2d_view<T>(std::span<size_t const>(offsets), values.data()); }
+            vector2d_view<T const> view() const noexcept { return vector2d_view<T const>(std::span<size_t const>(offsets), values.data()); }
+        };
 
-            for (auto& row : m_rows)
-            {
-                if (row.empty()) { continue; }
-                for (auto it = row.begin(); it != row.end(); ++it)
-                {
-                    data.emplace_back(*it);
-                }
-                size_t const size = row.size();
-                row.shrink_to_fit();
-                row.update(data.size() - size, size);
-            }
+        // Export the rows in CSR format by copying the elements, the values are allocated by alloc or by the allocator of this vector2d.
+        csr_type export_csr(Allocator const& alloc) const;
+        csr_type export_csr() const& { return this->export_csr(m_data.get_allocator()); }
+        // Export the rows in CSR format, the buffer of elements is moved out after compaction.
+        csr_type export_csr() &&;
 
-            m_data.swap(data);
+        /**
+         * Copy the rows into an immutable compacted CSR held by std::shared_ptr, e.g. to hand one copy to many
+         * reader threads, which scan it through view() while this vector2d keeps changing. Every call copies all
+         * the elements, only passing the pointer on is O(1). vector2d(offsets, std::move(values)) of a copy gives
+         * back a mutable vector2d.
+         *
+         * The values are allocated by alloc rather than by the allocator of this vector2d, since the last holder
+         * frees them on its own thread at any time. So alloc has to outlive all holders and to be safe to use from
+         * any thread; the default Allocator() of std::pmr::vector2d takes the default memory resource.
+         *
+         * Time complexity: O(n + m), where n = number of rows, m = number of elements
+         */
+        std::shared_ptr<csr_type const> shared_copy(Allocator const& alloc = Allocator()) const
+        {
+            return std::make_shared<csr_type const>(this->export_csr(alloc));
         }
 
-        void print()
+        // Write the rows in the binary format of vector2d_file_header, which could be mapped by mapped_vector2d.
+        void save(std::ostream& os) const;
+        void save(std::string const& path) const;
+
+        growth_policy const& get_growth_policy() const noexcept { return m_growth; }
+        void set_growth_policy(growth_policy const& policy)
         {
-            std::cout << "vector2d: " << std::endl;
-            std::cout << "nrow: " << this->size() << std::endl;
-            std::cout << "nelement: " << this->m_data.size() << std::endl;
-            for (size_t n = 0; n < m_rows.size(); ++n)
+            if (!(policy.factor >= 1.0) || policy.min_slack > policy.max_slack)
             {
-                std::cout << "row[" << n << "]: " <<  "[";
-                for (size_t i = m_rows[n].begin_index(); i < m_rows[n].end_index(); ++i)
-                {
-                    std::cout << " " << m_data[i];
-                }
-                std::cout << "] size:" << m_rows[n].size() << " capacity:" << m_rows[n].capacity() << " begin:" << m_rows[n].begin_index()
-                    << std::endl;
+                std::ostringstream ms;
+                ms << "ollib::vector2d::set_growth_policy(): input factor " << policy.factor << " cannot be less than 1, or min_slack "
+                    << policy.min_slack << " cannot be greater than max_slack " << policy.max_slack;
+                throw std::out_of_range(ms.str());
             }
+            m_growth = policy;
+        }
 
-            for (auto& data : m_data)
+        compaction_policy const& get_compaction_policy() const noexcept { return m_compaction; }
+        void set_compaction_policy(compaction_policy const& policy)
+        {
+            if (!(policy.garbage_ratio > 0.0 && policy.garbage_ratio <= 1.0))
             {
-                std::cout << data << " ";
+                std::ostringstream ms;
+                ms << "ollib::vector2d::set_compaction_policy(): input garbage_ratio " << policy.garbage_ratio << " is out of range (0, 1].";
+                throw std::out_of_range(ms.str());
             }
+            m_compaction = policy;
+            this->auto_compact();
         }
 
-    private:
+#ifdef VECTOR2D_ENABLE_STATS
+        // The statistics collected since construction, assignment or the last reset_stats(), a copy or an assigned
+        // vector2d starts with empty statistics.
+        vector2d_stats const& stats() const noexcept { return m_stats; }
+        void reset_stats() noexcept { m_stats = vector2d_stats(); }
+#endif
+
+        // The number of elements in rows.
+        size_t nelement() const noexcept { return m_nelement; }
+        // The number of elements in the holes of m_data, which are not owned by any row.
+        size_t ngarbage() const noexcept { return m_holes.size(); }
+        // The number of elements in the spare capacity of rows.
+        size_t nspare() const noexcept { return m_data.size() - m_nelement - m_holes.size(); }
+        double garbage_ratio() const noexcept
+        {
+            return m_data.empty() ? 0.0 : static_cast<double>(m_holes.size()) / static_cast<double>(m_data.size());
+        }
 
-        void append(size_t count, T const& value);
-        void move_desc(size_t ibegin, size_t iend, size_t new_ibegin);
-        void move_asc(size_t ibegin, size_t iend, size_t new_ibegin);
+        /**
+         * The compaction modes of compact():
+         * relayout: Move the rows into a new buffer in the order of rows, which holds two buffers during compaction.
+         * in_place: Slide the rows down inside m_data in the order of begin index, which keeps the order of
+         *           elements in m_data and doesn't need a second buffer.
+         */
+        enum class compact_mode { relayout, in_place };
 
-        // calling destructor of value type
-        void destroy(size_t index) { this->destroy(m_data[index]); }
-        void destroy(T& element) { m_data.get_allocator().destroy(&element); }
+        // Remove the garbage and the spare capacity of rows.
+        void compact(compact_mode mode = compact_mode::relayout)
+        {
+            VECTOR2D_STATS(vector2d_stats::compaction_scope scope(m_stats));
+            if (mode == compact_mode::in_place)
+            {
+                this->compact_in_place();
+                return;
+            }
 
-        std::vector<row_type> m_rows;
-        std::vector<T> m_data;
+            data_type data(m_data.get_allocator());
+            data.reserve(nelement());
 
-    }; /* end class vector2d */
+            for (auto& row : m_rows) { this->move_row(row, data); }
 
-    template <class T>
-    void vector2d<T>::row_type::reserve(size_t size)
-    {
-        if (size <= m_capacity) { return; }
+            m_data.swap(data);
+            m_holes.clear();
+        }
 
-        if (this->end() != m_container->m_data.end())
+        /**
+         * Compact like compact_mode::relayout, but the rows are laid out in m_data in the given order
+         * of row indices, e.g. the order in which they are scanned, while the order of rows is kept.
+         *
+         * Time complexity: O(n + m), where n = number of rows, m = number of elements
+         */
+        void compact(std::vector<size_t> const& order)
         {
-            m_container->append(size, T());
-            m_container->move_desc(this->begin_index(),
-                this->begin_index() + this->capacity() - 1,
-                m_container->m_data.size() - size);
-            // TODO: unused memory could be the capacity of previous/next Row.
+            this->check_permutation(order, "compact");
+            VECTOR2D_STATS(vector2d_stats::compaction_scope scope(m_stats));
 
-            this->update(m_container->m_data.size() - size, this->size());
-        }
-        else
+            data_type data(m_data.get_allocator());
+            data.reserve(nelement());
+
+            for (size_t i : order) { this->move_row(m_rows[i], data); }
+
+            m_data.swap(data);
+            m_holes.clear();
+        }
+
+        /**
+         * Compact incrementally for the callers which can't pause for a whole compact(). Each step slides a
+         * bounded batch of rows down into the compacted region at the front of m_data, in the order of begin
+         * index like compact_mode::in_place, and the freed space goes back to the holes. Every row stays valid
+         * between steps and the container could be modified freely; a step which finds the layout changed
+         * since the previous step plans again from the front of m_data, which sorts the rows but moves nothing.
+         * m_data is never reallocated by a step, call shrink_to_fit() on m_data through compact() if needed.
+         *
+         * The step with max_elements moves rows until max_elements elements are moved, and at least one row.
+         * The step with deadline moves rows until the clock reaches deadline, and at least one row.
+         *
+         * Return true if the compaction is done, i.e. there are no holes and no spare capacity left.
+         *
+         * Time complexity: O(k) for a step which moves k elements, plus O(n log n) when it plans, where n = number of rows
+         */
+        bool compact_step(size_t max_elements)
+        {
+            size_t nmoved = 0;
+            return this->compact_steps([&nmoved, max_elements](size_t count) { return (nmoved += count) >= max_elements; });
+        }
+        template <class Clock, class Duration>
+        bool compact_step(std::chrono::time_point<Clock, Duration> const& deadline)
+        {
+            return this->compact_steps([&deadline](size_t) { return Clock::now() >= deadline; });
+        }
+
+        /**
+         * Compact like compact_mode::relayout with multiple threads. The begin index of each row is given by
+         * a parallel prefix sum over the sizes of rows, then the chunks of rows are moved into the new buffer
+         * concurrently. The new buffer is value-initialized before the elements are moved in.
+         *
+         * Time complexity: O(n / p + m / p + p), where n = number of rows, m = number of elements, p = number of threads.
+         */
+        template <class ExecutionPolicy, typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+        void compact(ExecutionPolicy&& policy)
+        {
+            this->compact_parallel(std::max<size_t>(std::thread::hardware_concurrency(), 1) * 4,
+                [&policy](size_t nchunk, auto const& fn)
+                {
+                    std::vector<size_t> chunks(nchunk);
+                    std::iota(chunks.begin(), chunks.end(), size_t(0));
+                    std::for_each(policy, chunks.begin(), chunks.end(), fn);
+                });
+        }
+        void compact(thread_pool& pool)
+        {
+            this->compact_parallel(pool.size() * 4, [&pool](size_t nchunk, auto const& fn) { pool.parallel_for(nchunk, fn); });
+        }
+
+        /**
+         * Call fn(row) for each row concurrently, row is row_type or const_row_type by value. fn could modify
+         * the elements of its row, but it must not change the size or the capacity of any row, which would
+         * reallocate the shared buffer.
+         */
+        template <class ExecutionPolicy, class F, typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+        void parallel_for_each_row(ExecutionPolicy&& policy, F fn)
+        {
+            std::for_each(std::forward<ExecutionPolicy>(policy), m_rows.begin(), m_rows.end(),
+                [this, &fn](row_record& row) { fn(row_type(this, &row)); });
+        }
+        template <class ExecutionPolicy, class F, typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+        void parallel_for_each_row(ExecutionPolicy&& policy, F fn) const
+        {
+            std::for_each(std::forward<ExecutionPolicy>(policy), m_rows.cbegin(), m_rows.cend(),
+                [this, &fn](row_record const& row) { fn(const_row_type(this, &row)); });
+        }
+        template <class F>
+        void parallel_for_each_row(thread_pool& pool, F fn)
+        {
+            this->for_each_row_chunk(pool, [this, &fn](size_t first, size_t last) { std::for_each(this->begin() + first, this->begin() + last, fn); });
+        }
+        template <class F>
+        void parallel_for_each_row(thread_pool& pool, F fn) const
+        {
+            this->for_each_row_chunk(pool, [this, &fn](size_t first, size_t last) { std::for_each(this->cbegin() + first, this->cbegin() + last, fn); });
+        }
+
+        /**
+         * Transpose the rows as an adjacency list of integers, e.g. get the reverse graph: each element j of row i
+         * becomes the element i of row j in the result, which has ncol rows and the elements of each row in
+         * ascending order. Every element must be in [0, ncol) and every row index must fit in T.
+         *
+         * The first pass counts the elements of each column by chunks of rows, the exclusive scan of the counts
+         * gives every chunk its own write offset in each result row, and the second pass scatters the chunks
+         * into one preallocated buffer, so the result has no garbage and no spare capacity. The overloads with
+         * an execution policy or a thread pool run both passes concurrently.
+         *
+         * Time complexity: O(n / p + m / p + c * p), where n = number of rows, m = number of elements, c = ncol,
+         * p = number of chunks, which is bounded so that c * p doesn't exceed m.
+         */
+        vector2d transpose(size_t ncol) const
+        {
+            return this->transpose_parallel(ncol, 1, [](size_t, auto const& fn) { fn(0); });
+        }
+        template <class ExecutionPolicy, typename = std::enable_if_t<std::is_execution_policy_v<std::decay_t<ExecutionPolicy>>>>
+        vector2d transpose(ExecutionPolicy&& policy, size_t ncol) const
+        {
+            return this->transpose_parallel(ncol, std::max<size_t>(std::thread::hardware_concurrency(), 1) * 4,
+                [&policy](size_t nchunk, auto const& fn)
+                {
+                    std::vector<size_t> chunks(nchunk);
+                    std::iota(chunks.begin(), chunks.end(), size_t(0));
+                    std::for_each(policy, chunks.begin(), chunks.end(), fn);
+                });
+        }
+        vector2d transpose(thread_pool& pool, size_t ncol) const
+        {
+            return this->transpose_parallel(ncol, pool.size() * 4, [&pool](size_t nchunk, auto const& fn) { pool.parallel_for(nchunk, fn); });
+        }
+
+        /**
+         * The live elements of all rows as the maximal contiguous runs of m_data, in the order of m_data rather
+         * than the order of rows. The holes and the spare capacity of rows are skipped, and the adjacent rows
+         * are merged into one run, so the elements after compact() are a single run. The runs are valid until
+         * any row is reallocated.
+         *
+         * Time complexity: O(n) if the rows are in the order of begin index, otherwise O(n log n), where n = number of rows
+         */
+        std::vector<std::span<T>> elements() { return this->element_runs<T>(); }
+        std::vector<std::span<T const>> elements() const { return this->element_runs<T const>(); }
+
+        void print()
+        {
+            std::cout << "vector2d: " << std::endl;
+            std::cout << "nrow: " << this->size() << std::endl;
+            std::cout << "nelement: " << this->m_data.size() << std::endl;
+            std::cout << "garbage: " << this->ngarbage() << std::endl;
+            for (size_t n = 0; n < m_rows.size(); ++n)
+            {
+                std::cout << "row[" << n << "]: " <<  "[";
+                for (size_t i = m_rows[n].begin_index(); i < m_rows[n].end_index(); ++i)
+                {
+                    std::cout << " " << m_data[i];
+                }
+                std::cout << "] size:" << m_rows[n].size() << " capacity:" << m_rows[n].capacity() << " begin:" << m_rows[n].begin_index()
+                    << std::endl;
+            }
+
+            for (auto& data : m_data)
+            {
+                std::cout << data << " ";
+            }
+        }
+
+    private:
+
+        /**
+         * The free space of m_data, a hole is a range of elements which isn't owned by any row.
+         * Holes are indexed by the begin index to merge the adjacent ones, and by the size for
+         * the best-fit lookup.
+         */
+        class hole_map
+        {
+
+        public:
+
+            static constexpr size_t npos = static_cast<size_t>(-1);
+
+            using begin_map = std::map<size_t, size_t, std::less<size_t>,
+                typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<size_t const, size_t>>>;
+            using size_set = std::set<std::pair<size_t, size_t>, std::less<std::pair<size_t, size_t>>,
+                typename std::allocator_traits<Allocator>::template rebind_alloc<std::pair<size_t, size_t>>>;
+
+            explicit hole_map(Allocator const& alloc)
+                : m_by_begin(typename begin_map::allocator_type(alloc))
+                , m_by_size(typename size_set::allocator_type(alloc))
+            {}
+            hole_map(hole_map const& other, Allocator const& alloc)
+                : m_by_begin(other.m_by_begin, typename begin_map::allocator_type(alloc))
+                , m_by_size(other.m_by_size, typename size_set::allocator_type(alloc))
+                , m_size(other.m_size)
+            {}
+            hole_map(hole_map const& other) = default;
+            hole_map(hole_map&& other) noexcept
+                : m_by_begin(std::move(other.m_by_begin))
+                , m_by_size(std::move(other.m_by_size))
+                , m_size(std::exchange(other.m_size, 0))
+            {}
+            hole_map& operator=(hole_map const& other) = default;
+            hole_map& operator=(hole_map&& other)
+            {
+                m_by_begin = std::move(other.m_by_begin);
+                m_by_size = std::move(other.m_by_size);
+                m_size = std::exchange(other.m_size, 0);
+                return *this;
+            }
+
+            bool empty() const noexcept { return m_by_begin.empty(); }
+            // The total number of elements in holes.
+            size_t size() const noexcept { return m_size; }
+            void clear() noexcept
+            {
+                m_by_begin.clear();
+                m_by_size.clear();
+                m_size = 0;
+            }
+
+            // Add the range [ibegin, ibegin + count) and merge it with the adjacent holes.
+            void insert(size_t ibegin, size_t count);
+
+            // Take the smallest hole which could hold count elements, return npos if there isn't any.
+            size_t acquire(size_t count);
+
+            // Take count elements from the front of the hole starting at ibegin, return false if it doesn't fit.
+            bool take(size_t ibegin, size_t count);
+
+            // Remove the hole ending at iend, return its begin index or npos if there isn't any.
+            size_t pop_back(size_t iend);
+
+            /* The begin index to size of holes. */
+            begin_map const& holes() const noexcept { return m_by_begin; }
+
+        private:
+
+            void emplace(size_t ibegin, size_t count)
+            {
+                m_by_begin.emplace(ibegin, count);
+                m_by_size.emplace(count, ibegin);
+                m_size += count;
+            }
+
+            void erase(typename begin_map::iterator it)
+            {
+                m_size -= it->second;
+                m_by_size.erase(std::make_pair(it->second, it->first));
+                m_by_begin.erase(it);
+            }
+
+            begin_map m_by_begin;
+            size_set m_by_size;
+            size_t m_size = 0;
+
+        }; /* end class hole_map */
+
+        // Allocate count elements in m_data for a row, the holes are reused first.
+        size_t allocate(size_t count);
+        // Give the range back to the free space, the holes at the end of m_data are removed.
+        void deallocate(size_t ibegin, size_t count);
+        // Destroy the elements of the row, which keeps its capacity.
+        void clear_row(row_record& row)
+        {
+            if (row.empty()) { return; }
+            for (size_t i = row.begin_index(); i < row.end_index(); ++i) { this->destroy(m_data[i]); }
+            m_nelement -= row.size();
+            row.m_size = 0;
+        }
+        // Clear the row and give its memory back to the free space.
+        void release(row_record& row)
+        {
+            this->clear_row(row);
+            this->deallocate(row.begin_index(), row.capacity());
+        }
+        // Move the elements of the row to the end of data, and place the row there without spare capacity.
+        void move_row(row_record& row, data_type& data)
+        {
+            size_t const ibegin = data.size();
+            data.insert(data.end(), std::make_move_iterator(m_data.begin() + row.begin_index()),
+                std::make_move_iterator(m_data.begin() + row.end_index()));
+            row.relayout(ibegin);
+        }
+        void compact_in_place();
+        // The row which compact_step() moves next, the row is skipped from the plan if its layout changed.
+        struct compact_plan_entry
+        {
+            size_t index;
+            size_t ibegin;
+            size_t capacity;
+        };
+        // Run compact_step() until stop(count) returns true after a row of count elements is moved.
+        template <class Stop>
+        bool compact_steps(Stop&& stop);
+        // Plan compact_step() from the front of m_data.
+        void plan_compact_steps();
+        // Drop the plan of compact_step(), e.g. when the rows are replaced.
+        void reset_compact_steps() noexcept
+        {
+            m_step_plan.clear();
+            m_step_next = 0;
+            m_step_frontier = 0;
+        }
+        // Move the next row of the plan to the frontier, return false if the layout changed since planning.
+        bool compact_next_row();
+        // Compact like compact_mode::relayout, for_each_chunk(nchunk, fn) calls fn(i) for each i in [0, nchunk) concurrently.
+        template <class ForEachChunk>
+        void compact_parallel(size_t nchunk, ForEachChunk&& for_each_chunk);
+        // Transpose by at most nchunk chunks of rows, for_each_chunk is called like compact_parallel().
+        template <class ForEachChunk>
+        vector2d transpose_parallel(size_t ncol, size_t nchunk, ForEachChunk&& for_each_chunk) const;
+        template <typename U>
+        std::vector<std::span<U>> element_runs() const;
+        // Call fn(first, last) for the chunks of rows [first, last) on the threads of pool.
+        template <class F>
+        void for_each_row_chunk(thread_pool& pool, F&& fn) const
+        {
+            size_t const nrow = m_rows.size();
+            size_t const nchunk = std::min(nrow, pool.size() * 4);
+            pool.parallel_for(nchunk, [nrow, nchunk, &fn](size_t i) { fn(nrow * i / nchunk, nrow * (i + 1) / nchunk); });
+        }
+        // Compact when the holes and the spare capacity exceed the compaction policy.
+        void auto_compact()
+        {
+            size_t const garbage = m_holes.size() + this->nspare();
+            if (garbage > m_compaction.min_garbage
+                && static_cast<double>(garbage) > m_compaction.garbage_ratio * static_cast<double>(m_data.size()))
+            {
+                this->compact(compact_mode::in_place);
+            }
+        }
+        // Move the rows into a new buffer in the order of rows, row i has at least the capacity capacity_of(i).
+        template <class F>
+        void layout_rows(F&& capacity_of);
+        // Throw if perm isn't a permutation of the row indices.
+        void check_permutation(std::vector<size_t> const& perm, char const* func) const
+        {
+            std::vector<bool> seen(m_rows.size(), false);
+            bool valid = perm.size() == m_rows.size();
+            for (auto it = perm.begin(); valid && it != perm.end(); ++it)
+            {
+                valid = *it < m_rows.size() && !seen[*it];
+                if (valid) { seen[*it] = true; }
+            }
+            if (!valid)
+            {
+                std::ostringstream ms;
+                ms << "ollib::vector2d::" << func << "(): input order of " << perm.size() << " indices isn't a permutation of "
+                    << m_rows.size() << " rows.";
+                throw std::out_of_range(ms.str());
+            }
+        }
+        // Erase the rows for which remove(index, row) returns true, see erase_rows_if().
+        template <class F>
+        size_t erase_rows_where(F&& remove, bool compact_data);
+        // Insert the rows before index with one reservation of m_data and one shift of m_rows.
+        template <bool Move, class ForwardIt>
+        row_iterator insert_rows(size_t index, ForwardIt first, ForwardIt last);
+        // Store the range in a hole or at the end of m_data, return the begin index.
+        template <class InputIt>
+        size_t store(InputIt first, InputIt last);
+
+        void append(size_t count, T const& value);
+        // Make sure count more elements fit in m_data without reallocation, the capacity grows geometrically
+        // so that repeated appends cost amortized O(1) per element.
+        void reserve_data(size_t count)
+        {
+            this->check_growth(m_data.size(), count);
+            size_t const required = m_data.size() + count;
+            if (required <= m_data.capacity()) { return; }
+            VECTOR2D_STATS(size_t const old_capacity = m_data.capacity());
+            m_data.reserve(std::min(std::max(required, m_data.capacity() * 2), max_index));
+            VECTOR2D_STATS(this->count_reallocation(old_capacity));
+        }
+        // Throw if a buffer of size elements can't grow by count elements within max_index, it never throws for the default Index.
+        static void check_growth(size_t size, size_t count)
+        {
+            if constexpr (sizeof(Index) < sizeof(size_t))
+            {
+                if (count > max_index - size)
+                {
+                    std::ostringstream ms;
+                    ms << "ollib::vector2d: growing " << size << " elements by " << count
+                        << " elements exceeds the max_index " << max_index << " of the index type.";
+                    throw std::length_error(ms.str());
+                }
+            }
+        }
+        // Throw if nrow rows of ncol elements don't fit, before their product could overflow.
+        static void check_growth(size_t size, size_t nrow, size_t ncol)
+        {
+            if (ncol != 0 && nrow > max_index / ncol)
+            {
+                std::ostringstream ms;
+                ms << "ollib::vector2d: " << nrow << " rows of " << ncol << " elements exceed the max_index " << max_index
+                    << " of the index type.";
+                throw std::length_error(ms.str());
+            }
+            check_growth(size, nrow * ncol);
+        }
+#ifdef VECTOR2D_ENABLE_STATS
+        // Count the reallocation of m_data if its capacity changed from old_capacity.
+        void count_reallocation(size_t old_capacity) noexcept
+        {
+            if (m_data.capacity() == old_capacity) { return; }
+            ++m_stats.reallocations;
+            m_stats.reallocated_bytes += m_data.capacity() * sizeof(T);
+            m_stats.max_capacity = std::max(m_stats.max_capacity, m_data.capacity());
+        }
+#endif
+        // Move the elements in [ibegin, iend) to new_ibegin, from the last one to the first one.
+        void move_desc(size_t ibegin, size_t iend, size_t new_ibegin);
+        // Move the elements in [ibegin, iend) to new_ibegin, from the first one to the last one.
+        void move_asc(size_t ibegin, size_t iend, size_t new_ibegin);
+        // The trivially copyable elements are moved by memmove in both directions.
+        void move_desc(size_t ibegin, size_t iend, size_t new_ibegin, std::true_type);
+        void move_desc(size_t ibegin, size_t iend, size_t new_ibegin, std::false_type);
+        void move_asc(size_t ibegin, size_t iend, size_t new_ibegin, std::true_type);
+        void move_asc(size_t ibegin, size_t iend, size_t new_ibegin, std::false_type);
+
+        // Release the resources held by the element, which stays alive in m_data until m_data destroys it.
+        void destroy(T& element) { this->destroy(element, std::is_trivially_destructible<T>()); }
+        void destroy(T&, std::true_type) {}
+        void destroy(T& element, std::false_type) { element = T(); }
+
+        rows_type m_rows;
+        data_type m_data;
+        hole_map m_holes;
+        growth_policy m_growth;
+        compaction_policy m_compaction;
+        size_t m_nelement = 0;
+        // The state of compact_step(), rows before m_step_frontier are compacted, which isn't copied.
+        std::vector<compact_plan_entry> m_step_plan;
+        size_t m_step_next = 0;
+        size_t m_step_frontier = 0;
+#ifdef VECTOR2D_ENABLE_STATS
+        vector2d_stats m_stats;
+#endif
+
+    }; /* end class vector2d */
+
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::row_type::reserve(size_t size)
+    {
+        this->grow(size, vector2d_stats::reserve);
+        m_container->auto_compact();
+    }
+
+    /**
+     * There are 3 situations while growing the capacity of row:
+     * 1. The row is at the end of m_data: We append the extra spaces to the end.
+     * 2. The row is followed by a hole: We take the extra spaces from the front of the hole.
+     * 3. Otherwise: We allocate a new place from the holes or the end of m_data, move the elements to the
+     *    new place, and give the original place back to the free space for other rows.
+     *
+     * Time complexity: O(m), where m = size of the row plus reallocation if required.
+     */
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::row_type::grow(size_t capacity, [[maybe_unused]] vector2d_stats::operation op)
+    {
+        if (capacity <= m_record->m_capacity) { return; }
+
+        size_t const extra = capacity - m_record->m_capacity;
+        size_t const iend = m_record->m_begin_index + m_record->m_capacity;
+
+        if (m_record->m_capacity != 0 && iend == m_container->m_data.size())
         {
-            m_container->append(size - this->size(), T());
+            m_container->append(extra, T());
         }
-        m_capacity = size;
+        else if (m_record->m_capacity == 0 || !m_container->m_holes.take(iend, extra))
+        {
+            size_t const ibegin = m_container->allocate(capacity);
+            VECTOR2D_STATS(++m_container->m_stats.relocations[op]);
+            VECTOR2D_STATS(m_container->m_stats.relocated_elements[op] += m_record->m_size);
+            m_container->move_desc(m_record->m_begin_index, this->end_index(), ibegin);
+            m_container->deallocate(m_record->m_begin_index, m_record->m_capacity);
+            m_record->m_begin_index = static_cast<Index>(ibegin);
+        }
+
+        m_record->m_capacity = static_cast<Index>(capacity);
     }
 
     /**
-     * There are basically 3 situation while inserting element in our case:
-     * 1. The capacity is enough: We move the elements after the insertion pos backwardly and fill the range.
-     * 2. The capacity is not enough and the row is not the last one: We append required spaces (nelement of row + insertion size) to the end,
-     *    we move the elements before insertion pos backwardly, then fill the range, finally move the remaining of elements to the back.
-     * 3. The capacity is not enough and the row is the last one: We append required spaces (insertion size) to the end, then
-     *    move elements after the insertion pos backwardly and fill the range.
+     * We grow the capacity by the growth policy first if it's not enough, then move the elements after the insertion pos
+     * backwardly and fill the range. A single-pass range is read into a buffer first, and so is a range which needs the
+     * row to grow, since it might refer to the elements of container which the growth moves.
      *
      * Time complexity: O(m), where m = size of the row plus reallocation if required.
      */
-    template <class T>
+    template <class T, class Allocator, class Index>
     template <class InputIt>
-    typename std::vector<T>::iterator vector2d<T>::row_type::insert(const_iterator pos, InputIt first, InputIt last)
+    typename vector2d<T, Allocator, Index>::row_type::iterator vector2d<T, Allocator, Index>::row_type::insert(const_iterator pos, InputIt first, InputIt last)
     {
         size_t const diff = pos - this->begin();
         if (diff > this->size() || diff < 0)
@@ -389,7 +1443,13 @@ namespace std
             throw std::out_of_range(ms.str());
         }
 
-        size_t const range = last - first;
+        if constexpr (!std::is_base_of<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category>::value)
+        {
+            std::vector<T> values(first, last);
+            return this->insert(pos, std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+        }
+
+        size_t const range = std::distance(first, last);
         if (range < 0)
         {
             std::ostringstream ms;
@@ -400,87 +1460,565 @@ namespace std
         // Return pos if first==last.
         if (range == 0) { return this->begin() + diff; }
 
-        if (this->size() + range <= this->capacity())
+        if (this->size() + range > this->capacity())
+        {
+            std::vector<T> values(first, last);
+            this->expand(this->size() + range, vector2d_stats::insert);
+            return this->insert(this->cbegin() + diff, std::make_move_iterator(values.begin()), std::make_move_iterator(values.end()));
+        }
+
+        m_container->move_desc(this->begin_index() + diff,
+            this->end_index(),
+            this->begin_index() + diff + range);
+
+        size_t index = this->begin_index() + diff;
+        for (auto it = first; it != last; ++it, ++index)
         {
-            m_container->move_desc(this->begin_index() + diff,
-                this->end_index() - 1,
-                this->begin_index() + diff + range);
+            m_container->m_data[index] = *it;
+        }
+
+        this->update(this->begin_index(), this->size() + range);
+        m_container->auto_compact();
+
+        return this->begin() + diff;
+    }
+
+    template <class T, class Allocator, class Index>
+    typename vector2d<T, Allocator, Index>::row_type::iterator vector2d<T, Allocator, Index>::row_type::insert(const_iterator pos, const T& value)
+    {
+        return this->emplace(pos, value);
+    }
+
+    template <class T, class Allocator, class Index>
+    typename vector2d<T, Allocator, Index>::row_type::iterator vector2d<T, Allocator, Index>::row_type::insert(const_iterator pos, T&& value)
+    {
+        return this->emplace(pos, std::move(value));
+    }
 
-            for (auto it = first; it != last; ++it)
+    /**
+     * The value is constructed before growing the row, since args might refer to the elements of container.
+     *
+     * Time complexity: O(m), where m = size of the row plus reallocation if required.
+     */
+    template <class T, class Allocator, class Index>
+    template <class... Args>
+    typename vector2d<T, Allocator, Index>::row_type::iterator vector2d<T, Allocator, Index>::row_type::emplace(const_iterator pos, Args&&... args)
+    {
+        size_t const diff = pos - this->begin();
+        if (diff > this->size())
+        {
+            std::ostringstream ms;
+            ms << "ollib::vector2d::row_type::emplace(): input pos " << diff << " is out of range.";
+            throw std::out_of_range(ms.str());
+        }
+
+        T value(std::forward<Args>(args)...);
+        this->expand(this->size() + 1, vector2d_stats::insert);
+
+        m_container->move_desc(this->begin_index() + diff,
+            this->end_index(),
+            this->begin_index() + diff + 1);
+        m_container->m_data[this->begin_index() + diff] = std::move(value);
+
+        this->update(this->begin_index(), this->size() + 1);
+        m_container->auto_compact();
+
+        return this->begin() + diff;
+    }
+
+    /**
+     * In erase(), we only have to move the elements after the last erase pos forwardly, and leave the space
+     * there to be capacity of this row.
+     *
+     * Time complexity: O(m), where m = size of the row.
+     */
+    template <class T, class Allocator, class Index>
+    typename vector2d<T, Allocator, Index>::row_type::iterator vector2d<T, Allocator, Index>::row_type::erase(const_iterator first, const_iterator last)
+    {
+        size_t const fdiff = first - this->begin();
+        if (fdiff > this->size() || fdiff < 0)
+        {
+            std::ostringstream ms;
+            ms << "ollib::vector2d::row_type::erase(): input fisrt " << fdiff << " is out of range.";
+            throw std::out_of_range(ms.str());
+        }
+
+        size_t const ldiff = last - this->begin();
+        if (ldiff > this->size() || ldiff < 0)
+        {
+            std::ostringstream ms;
+            ms << "ollib::vector2d::row_type::erase(): input last " << ldiff << " is out of range.";
+            throw std::out_of_range(ms.str());
+        }
+
+        size_t const range = last - first;
+        if (range < 0)
+        {
+            std::ostringstream ms;
+            ms << "ollib::vector2d::row_type::erase(): input range is invalid.";
+            throw std::out_of_range(ms.str());
+        }
+
+        // Return last if first==last.
+        if (range == 0) { return this->begin() + ldiff; }
+
+        // Destruct elements in [first, last)
+        for (auto it = this->begin() + fdiff; it != this->begin() + ldiff; ++it) { m_container->destroy(*it); }
+
+        m_container->move_asc(this->begin_index() + ldiff,
+            this->end_index(),
+            this->begin_index() + ldiff - range);
+
+        this->update(this->begin_index(), this->size() - range);
+        m_container->auto_compact();
+
+        return this->begin() + fdiff;
+    }
+
+    template <class T, class Allocator, class Index>
+    typename vector2d<T, Allocator, Index>::row_type::iterator vector2d<T, Allocator, Index>::row_type::erase(const_iterator pos)
+    {
+        size_t const diff = pos - begin();
+        return this->erase(begin() + diff, begin() + diff + 1);
+    }
+
+    /**
+     * The idea of push_back is similar to insert(), the row grows by the growth policy only when the capacity is full.
+     * When the row is full and at the end of m_data, the element is constructed in place by m_data.emplace_back.
+     *
+     * Time complexity: amortized O(1) with the default growth policy.
+     */
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::row_type::push_back(T const& value)
+    {
+        this->emplace_back(value);
+    }
+
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::row_type::push_back(T&& value)
+    {
+        this->emplace_back(std::move(value));
+    }
+
+    template <class T, class Allocator, class Index>
+    template <class... Args>
+    void vector2d<T, Allocator, Index>::row_type::emplace_back(Args&&... args)
+    {
+        auto& data = m_container->m_data;
+
+        if (this->size() < this->capacity())
+        {
+            data[this->end_index()] = T(std::forward<Args>(args)...);
+        }
+        else if (m_record->m_capacity == 0 || m_record->m_begin_index + m_record->m_capacity == data.size())
+        {
+            m_container->check_growth(data.size(), 1);
+            if (m_record->m_capacity == 0) { m_record->m_begin_index = static_cast<Index>(data.size()); }
+            VECTOR2D_STATS(size_t const old_capacity = data.capacity());
+            data.emplace_back(std::forward<Args>(args)...);
+            VECTOR2D_STATS(m_container->count_reallocation(old_capacity));
+            ++m_record->m_capacity;
+        }
+        else
+        {
+            // args might refer to the elements of container.
+            T value(std::forward<Args>(args)...);
+            this->expand(this->size() + 1, vector2d_stats::push_back);
+            data[this->end_index()] = std::move(value);
+        }
+
+        this->update(this->begin_index(), this->size() + 1);
+        m_container->auto_compact();
+    }
+
+    /**
+     * There are 3 situations in resize():
+     * 1. Request smaller size: We only shrink the size and leave the remaining space as the capacity of this row.
+     * 2. Request bigger size and the capacity is enough: Fill the range of value in the capacity.
+     * 3. Request bigger size and the capacity is not enough: We grow the capacity by the growth policy, then fill the remaining
+     *    elements with value.
+     *
+     * Time complexity: O(m), where m = size of the row plus reallocation if required.
+     */
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::row_type::resize(size_t size, T const& value)
+    {
+        if (size <= this->size())
+        {
+            // Reduce the size but keep the capacity as before.
+            this->update(this->begin_index(), size);
+            m_container->auto_compact();
+            return;
+        }
+
+        this->expand(size, vector2d_stats::resize);
+
+        for (size_t i = this->end_index(); i < this->begin_index() + size; ++i)
+        {
+            m_container->m_data[i] = value;
+        }
+        this->update(this->begin_index(), size);
+        m_container->auto_compact();
+    }
+
+    template <class T, class Allocator, class Index>
+    vector2d<T, Allocator, Index>::vector2d(std::vector<size_t> const& offsets, data_type&& values)
+        : vector2d(values.get_allocator())
+    {
+        for (size_t i = 1; i < offsets.size(); ++i)
+        {
+            if (offsets[i] < offsets[i - 1] || offsets[i] > values.size())
+            {
+                std::ostringstream ms;
+                ms << "ollib::vector2d(): input offsets " << offsets[i - 1] << ", " << offsets[i] << " is out of range.";
+                throw std::out_of_range(ms.str());
+            }
+        }
+        if (offsets.size() < 2) { return; }
+        this->check_growth(m_data.size(), offsets.back());
+
+        m_data = std::move(values);
+        // The elements out of [offsets.front(), offsets.back()) don't belong to any row.
+        m_data.erase(m_data.begin() + offsets.back(), m_data.end());
+        this->deallocate(0, offsets.front());
+
+        m_rows.reserve(offsets.size() - 1);
+        for (size_t i = 1; i < offsets.size(); ++i)
+        {
+            m_rows.emplace_back(offsets[i - 1], offsets[i] - offsets[i - 1]);
+        }
+        m_nelement = offsets.back() - offsets.front();
+    }
+
+    template <class T, class Allocator, class Index>
+    vector2d<T, Allocator, Index>::vector2d(std::vector<std::vector<T>>&& rows, Allocator const& alloc)
+        : vector2d(alloc)
+    {
+        auto acc_func = [](size_t accumulator, std::vector<T> const& r)
+        { return accumulator + r.size(); };
+        size_t const nelement = std::accumulate(rows.begin(), rows.end(), size_t(0), acc_func);
+
+        this->check_growth(m_data.size(), nelement);
+        m_rows.reserve(rows.size());
+        m_data.reserve(nelement);
+
+        for (auto& row : rows)
+        {
+            m_rows.emplace_back(m_data.size(), row.size());
+            for (auto& value : row) { m_data.emplace_back(std::move(value)); }
+        }
+        m_nelement = nelement;
+    }
+
+    template <class T, class Allocator, class Index>
+    template <class OffsetIt, class ValueIt>
+    vector2d<T, Allocator, Index> vector2d<T, Allocator, Index>::from_csr(OffsetIt offsets_first, OffsetIt offsets_last, ValueIt values_first,
+        Allocator const& alloc)
+    {
+        vector2d<T, Allocator, Index> result(alloc);
+        if (offsets_first == offsets_last) { return result; }
+
+        size_t const ibase = *offsets_first;
+        size_t ibegin = ibase;
+        result.m_rows.reserve(std::distance(offsets_first, offsets_last) - 1);
+        for (auto it = std::next(offsets_first); it != offsets_last; ++it)
+        {
+            size_t const iend = *it;
+            if (iend < ibegin)
             {
-                size_t pos = it - first;
-                m_container->m_data[this->begin_index() + diff + pos] = *it;
+                std::ostringstream ms;
+                ms << "ollib::vector2d::from_csr(): input offsets " << ibegin << ", " << iend << " is out of range.";
+                throw std::out_of_range(ms.str());
             }
+            result.m_rows.emplace_back(ibegin - ibase, iend - ibegin);
+            ibegin = iend;
+        }
+
+        size_t const nelement = ibegin - ibase;
+        result.check_growth(result.m_data.size(), nelement);
+        auto first = values_first;
+        std::advance(first, ibase);
+        result.m_data.reserve(nelement);
+        for (size_t i = 0; i < nelement; ++i, ++first) { result.m_data.emplace_back(*first); }
+        result.m_nelement = nelement;
+
+        return result;
+    }
+
+    template <class T, class Allocator, class Index>
+    vector2d<T, Allocator, Index>::vector2d(vector2d const& other, copy_mode mode)
+        : m_rows(other.m_rows)
+        , m_data(mode == copy_mode::exact ? data_type(other.m_data)
+            : data_type(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.m_data.get_allocator())))
+        , m_holes(mode == copy_mode::exact ? hole_map(other.m_holes)
+            : hole_map(std::allocator_traits<Allocator>::select_on_container_copy_construction(other.m_data.get_allocator())))
+        , m_growth(other.m_growth)
+        , m_compaction(other.m_compaction)
+        , m_nelement(other.m_nelement)
+    {
+        if (mode == copy_mode::exact) { return; }
+
+        m_data.reserve(m_nelement);
+        for (auto& row : m_rows)
+        {
+            size_t const ibegin = m_data.size();
+            m_data.insert(m_data.end(), other.m_data.begin() + row.begin_index(), other.m_data.begin() + row.end_index());
+            row.relayout(ibegin);
+        }
+    }
+
+    template <class T, class Allocator, class Index>
+    typename vector2d<T, Allocator, Index>::csr_type vector2d<T, Allocator, Index>::export_csr(Allocator const& alloc) const
+    {
+        csr_type csr{ std::vector<size_t>(), data_type(alloc) };
+        csr.offsets.reserve(m_rows.size() + 1);
+        csr.values.reserve(m_nelement);
+
+        csr.offsets.push_back(0);
+        for (auto& row : m_rows)
+        {
+            csr.values.insert(csr.values.end(), m_data.begin() + row.begin_index(), m_data.begin() + row.end_index());
+            csr.offsets.push_back(csr.values.size());
+        }
+
+        return csr;
+    }
+
+    template <class T, class Allocator, class Index>
+    typename vector2d<T, Allocator, Index>::csr_type vector2d<T, Allocator, Index>::export_csr() &&
+    {
+        // Skip the compaction if the rows are already stored contiguously in order.
+        size_t ibegin = 0;
+        bool compacted = m_data.size() == m_nelement;
+        for (auto it = m_rows.begin(); compacted && it != m_rows.end(); ++it)
+        {
+            compacted = it->empty() || it->begin_index() == ibegin;
+            ibegin += it->size();
+        }
+        if (!compacted) { this->compact(); }
+
+        // The buffer is moved out with its allocator, so it's never copied.
+        csr_type csr{ std::vector<size_t>(), std::move(m_data) };
+        csr.offsets.reserve(m_rows.size() + 1);
+        csr.offsets.push_back(0);
+        for (auto& row : m_rows) { csr.offsets.push_back(csr.offsets.back() + row.size()); }
+
+        this->clear();
+        return csr;
+    }
+
+    /**
+     * The adjacent rows are written by one call, so a compacted vector2d writes its elements at once.
+     */
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::save(std::ostream& os) const
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "vector2d::save() requires trivially copyable elements");
+
+        vector2d_file_header header{};
+        std::memcpy(header.magic, vector2d_file_header::magic_string, sizeof(header.magic));
+        header.version = vector2d_file_header::current_version;
+        header.byte_order = vector2d_file_header::native_byte_order;
+        header.value_size = sizeof(T);
+        header.nrow = m_rows.size();
+        header.nelement = m_nelement;
+        header.offsets_offset = sizeof(vector2d_file_header);
+        uint64_t const offsets_end = header.offsets_offset + (header.nrow + 1) * sizeof(uint64_t);
+        uint64_t const alignment = vector2d_file_header::alignment;
+        header.values_offset = (offsets_end + alignment - 1) / alignment * alignment;
+
+        os.write(reinterpret_cast<char const*>(&header), sizeof(header));
+
+        uint64_t offset = 0;
+        os.write(reinterpret_cast<char const*>(&offset), sizeof(offset));
+        for (auto& row : m_rows)
+        {
+            offset += row.size();
+            os.write(reinterpret_cast<char const*>(&offset), sizeof(offset));
+        }
+
+        char const padding[vector2d_file_header::alignment] = {};
+        os.write(padding, header.values_offset - offsets_end);
+
+        size_t ibegin = 0;
+        size_t iend = 0;
+        for (auto& row : m_rows)
+        {
+            if (row.empty()) { continue; }
+            if (row.begin_index() != iend)
+            {
+                os.write(reinterpret_cast<char const*>(m_data.data() + ibegin), (iend - ibegin) * sizeof(T));
+                ibegin = row.begin_index();
+            }
+            iend = row.end_index();
+        }
+        os.write(reinterpret_cast<char const*>(m_data.data() + ibegin), (iend - ibegin) * sizeof(T));
+
+        if (!os)
+        {
+            std::ostringstream ms;
+            ms << "ollib::vector2d::save(): failed to write " << header.nrow << " rows.";
+            throw std::runtime_error(ms.str());
+        }
+    }
+
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::save(std::string const& path) const
+    {
+        std::ofstream os(path, std::ios::binary | std::ios::trunc);
+        if (!os)
+        {
+            std::ostringstream ms;
+            ms << "ollib::vector2d::save(): failed to open " << path << ".";
+            throw std::runtime_error(ms.str());
+        }
+        this->save(os);
+    }
+
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::push_back(std::initializer_list<T> const& arr)
+    {
+        auto nelement = arr.end() - arr.begin();
+        // Insert range data to m_data
+        size_t const ibegin = this->store(arr.begin(), arr.end());
+        // Add new row
+        m_rows.emplace_back(ibegin, nelement);
+        m_nelement += nelement;
+    }
+
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::push_back(std::vector<T> const& arr)
+    {
+        auto nelement = arr.end() - arr.begin();
+        // Insert range data to m_data
+        size_t const ibegin = this->store(arr.begin(), arr.end());
+        // Add new row
+        m_rows.emplace_back(ibegin, nelement);
+        m_nelement += nelement;
+    }
+
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::push_back(std::vector<T>&& arr)
+    {
+        auto nelement = arr.end() - arr.begin();
+        // Move range data to m_data
+        size_t const ibegin = this->store(std::make_move_iterator(arr.begin()), std::make_move_iterator(arr.end()));
+        // Add new row
+        m_rows.emplace_back(ibegin, nelement);
+        m_nelement += nelement;
+    }
+
+    template <class T, class Allocator, class Index>
+    template <class... Args>
+    typename vector2d<T, Allocator, Index>::row_iterator
+        vector2d<T, Allocator, Index>::emplace(const_row_iterator pos, Args&&... args)
+    {
+        size_t const nelement = sizeof...(Args);
+        size_t const diff = pos - this->begin();
 
-            this->update(this->begin_index(), this->size() + range);
+        // Construct the elements at the end of m_data, in place if m_data doesn't reallocate. Otherwise args might
+        // refer to the elements of m_data, so the elements are constructed before m_data grows once.
+        this->check_growth(m_data.size(), nelement);
+        if (m_data.size() + nelement <= m_data.capacity())
+        {
+            (m_data.emplace_back(std::forward<Args>(args)), ...);
         }
-        // When this->size() + range > this->capacity()
         else
         {
-            // When the row is not at the end.
-            if (this->end() != m_container->m_data.end())
-            {
-                m_container->append(this->size() + range, T());
-                m_container->move_desc(this->begin_index(),
-                    this->begin_index() + diff - 1,
-                    m_container->m_data.size() - this->size() - range);
+            std::array<T, sizeof...(Args)> values{ T(std::forward<Args>(args))... };
+            this->reserve_data(nelement);
+            for (T& value : values) { m_data.emplace_back(std::move(value)); }
+        }
 
-                for (auto it = first; it != last; ++it)
-                {
-                    size_t pos = it - first;
-                    m_container->m_data[m_container->m_data.size() - this->size() - range + diff + pos] = *it;
-                }
+        m_nelement += nelement;
+        m_rows.emplace(m_rows.begin() + diff, m_data.size() - nelement, nelement);
+        return this->begin() + diff;
+    }
+
+    template <class T, class Allocator, class Index>
+    template <class... Args>
+    void vector2d<T, Allocator, Index>::emplace_back(Args&&... args)
+    {
+        this->emplace(this->end(), std::forward<Args>(args)...);
+    }
 
-                m_container->move_desc(this->begin_index() + diff,
-                    this->end_index() - 1,
-                    m_container->m_data.size() - this->size() + diff);
+    template <class T, class Allocator, class Index>
+    template <class ForwardIt>
+    typename vector2d<T, Allocator, Index>::row_iterator
+        vector2d<T, Allocator, Index>::insert(const_row_iterator pos, ForwardIt first, ForwardIt last)
+    {
+        return this->insert_rows<false>(pos - this->cbegin(), first, last);
+    }
+
+    /**
+     * The first pass counts the elements to reserve m_data once, the second pass stores the rows into
+     * the holes or at the end of m_data, and then all new rows are inserted into m_rows by one shift.
+     *
+     * Time complexity: O(n + m), where n = number of rows in m_rows, m = number of inserted elements
+     */
+    template <class T, class Allocator, class Index>
+    template <bool Move, class ForwardIt>
+    typename vector2d<T, Allocator, Index>::row_iterator
+        vector2d<T, Allocator, Index>::insert_rows(size_t index, ForwardIt first, ForwardIt last)
+    {
+        size_t nrow = 0;
+        size_t nelement = 0;
+        for (auto it = first; it != last; ++it, ++nrow) { nelement += std::size(*it); }
 
-                // TODO: unused memory could be the capacity of previous/next Row.
+        // The rows might belong to this container, reserve before taking their iterators.
+        this->reserve_data(nelement);
 
-                this->update(m_container->m_data.size() - this->size() - range, this->size() + range);
+        rows_type rows(m_rows.get_allocator());
+        rows.reserve(nrow);
+        for (auto it = first; it != last; ++it)
+        {
+            auto&& row = *it;
+            size_t ibegin = 0;
+            if constexpr (Move)
+            {
+                ibegin = this->store(std::make_move_iterator(std::begin(row)), std::make_move_iterator(std::end(row)));
             }
-            // When the row is at the end.
             else
             {
-                m_container->append(range, T());
-                m_container->move_desc(this->begin_index() + diff,
-                    this->end_index() - 1,
-                    this->begin_index() + diff + range);
-
-                for (auto it = first; it != last; ++it)
-                {
-                    size_t pos = it - first;
-                    m_container->m_data[this->begin_index() + diff + pos] = *it;
-                }
-
-                this->update(this->begin_index(), this->size() + range);
+                ibegin = this->store(std::begin(row), std::end(row));
             }
+            rows.emplace_back(ibegin, std::size(row));
         }
+        m_nelement += nelement;
 
-        return this->begin() + diff;
+        m_rows.insert(m_rows.begin() + index, rows.begin(), rows.end());
+        return this->begin() + index;
     }
 
-    template <class T>
-    typename std::vector<T>::iterator vector2d<T>::row_type::insert(iterator pos, const T& value)
+    template <class T, class Allocator, class Index>
+    typename vector2d<T, Allocator, Index>::row_iterator
+        vector2d<T, Allocator, Index>::insert(row_iterator pos, const_row_type row)
     {
-        std::array<T, 1> tmp{ value };
-        return this->insert(pos, tmp.begin(), tmp.end());
+        size_t const index = pos - this->begin();
+        // The row might belong to this container, reserve before taking its iterators.
+        this->reserve_data(row.size());
+
+        size_t const size = row.size();
+        size_t const ibegin = this->store(row.begin(), row.end());
+        m_rows.emplace(m_rows.begin() + index, ibegin, size);
+        m_nelement += size;
+
+        return this->begin() + index;
     }
 
     /**
-     * In erase(), we only have to move the elements after the last erase pos forwardly, and leave the space
-     * there to be capacity of this row.
-     *
-     * Time complexity: O(m), where m = size of the row.
+     * The memory of erased rows is given back to the free space, it will be reused by
+     * the growth of other rows.
      */
-    template <class T>
-    typename std::vector<T>::iterator vector2d<T>::row_type::erase(const_iterator first, const_iterator last)
+    template <class T, class Allocator, class Index>
+    typename vector2d<T, Allocator, Index>::row_iterator
+        vector2d<T, Allocator, Index>::erase(const_row_iterator first, const_row_iterator last)
     {
         size_t const fdiff = first - this->begin();
         if (fdiff > this->size() || fdiff < 0)
         {
             std::ostringstream ms;
-            ms << "ollib::vector2d::row_type::erase(): input fisrt " << fdiff << " is out of range.";
+            ms << "ollib::vector2d::erase(): input fisrt " << fdiff << " is out of range.";
             throw std::out_of_range(ms.str());
         }
 
@@ -488,7 +2026,7 @@ namespace std
         if (ldiff > this->size() || ldiff < 0)
         {
             std::ostringstream ms;
-            ms << "ollib::vector2d::row_type::erase(): input last " << ldiff << " is out of range.";
+            ms << "ollib::vector2d::erase(): input last " << ldiff << " is out of range.";
             throw std::out_of_range(ms.str());
         }
 
@@ -496,282 +2034,613 @@ namespace std
         if (range < 0)
         {
             std::ostringstream ms;
-            ms << "ollib::vector2d::row_type::erase(): input range is invalid.";
+            ms << "ollib::vector2d::erase(): input range is invalid.";
             throw std::out_of_range(ms.str());
         }
 
         // Return last if first==last.
         if (range == 0) { return this->begin() + ldiff; }
 
-        // Destruct elements in [first, last)
-        for (auto it = this->begin() + fdiff; it != this->begin() + ldiff; ++it) { m_container->destroy(*it); }
-
-        m_container->move_asc(this->begin_index() + ldiff,
-            this->end_index(),
-            this->begin_index() + ldiff - range);
+        for (size_t i = fdiff; i < ldiff; ++i) { this->release(m_rows[i]); }
 
-        this->update(this->begin_index(), this->size() - range);
+        m_rows.erase(m_rows.begin() + fdiff, m_rows.begin() + ldiff);
+        this->auto_compact();
 
         return this->begin() + fdiff;
     }
 
-    template <class T>
-    typename std::vector<T>::iterator vector2d<T>::row_type::erase(const_iterator pos)
+    template <class T, class Allocator, class Index>
+    typename vector2d<T, Allocator, Index>::row_iterator
+        vector2d<T, Allocator, Index>::erase(const_row_iterator pos)
     {
         size_t const diff = pos - begin();
         return this->erase(begin() + diff, begin() + diff + 1);
     }
 
-    /**
-     * The idea of push_back is similar to insert(), it's worth noting that we call emplace_back
-     * when the row is empty or is already the last one.
-     *
-     * Time complexity: O(m), where m = size of the row.
-     */
-    template <class T>
-    void vector2d<T>::row_type::push_back(T const& value)
+    template <class T, class Allocator, class Index>
+    template <class F>
+    void vector2d<T, Allocator, Index>::layout_rows(F&& capacity_of)
     {
-        if (this->size() < this->capacity())
+        // A row keeps its capacity if it's larger than the requested one, like std::vector::reserve().
+        auto const capacity = [this, &capacity_of](size_t i) { return std::max({ m_rows[i].capacity(), capacity_of(i) }); };
+
+        size_t total = 0;
+        for (size_t i = 0; i < m_rows.size(); ++i) { total += capacity(i); }
+        this->check_growth(0, total);
+        data_type data(m_data.get_allocator());
+
+        data.reserve(total);
+
+        for (size_t i = 0; i < m_rows.size(); ++i)
         {
-            m_container->m_data[this->end_index()] = value;
-            this->update(this->begin_index(), this->size() + 1);
+            row_record& row = m_rows[i];
+            size_t const ibegin = data.size();
+            size_t const row_capacity = capacity(i);
+            this->move_row(row, data);
+            row.relayout(ibegin, row_capacity);
+            data.resize(ibegin + row.capacity());
         }
-        else
+
+        m_data.swap(data);
+        m_holes.clear();
+    }
+
+    template <class T, class Allocator, class Index>
+    template <class IndexRange>
+    size_t vector2d<T, Allocator, Index>::erase_rows(IndexRange const& indices, bool compact_data)
+    {
+        std::vector<size_t> sorted(std::begin(indices), std::end(indices));
+        std::sort(sorted.begin(), sorted.end());
+        sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+        if (!sorted.empty() && sorted.back() >= m_rows.size())
         {
-            // When this->size() == this->capacity()
-            if (!this->empty() && this->end_index() != m_container->m_data.size())
+            std::ostringstream ms;
+            ms << "ollib::vector2d::erase_rows(): input index " << sorted.back() << " is out of range.";
+            throw std::out_of_range(ms.str());
+        }
+
+        auto next = sorted.cbegin();
+        return this->erase_rows_where([&next, &sorted](size_t index, const_row_type)
             {
-                // Append elements of row to the end of m_data.
-                m_container->append(this->size() + 1, T());
-                // Move the original elements to new positions.
-                m_container->move_desc(this->begin_index(),
-                    this->end_index() - 1,
-                    m_container->m_data.size() - this->size() - 1);
+                if (next == sorted.cend() || *next != index) { return false; }
+                ++next;
+                return true;
+            }, compact_data);
+    }
 
-                // TODO: unused memory could be the capacity of previous/next Row.
+    /**
+     * There are 2 situations in erase_rows_where():
+     * 1. compact_data is false: The erased rows give their memory back to the free space, and the surviving rows slide
+     *    down in m_rows without moving their elements.
+     * 2. compact_data is true: The surviving rows are moved into a new buffer in the order of rows, and the erased rows
+     *    are destroyed with the old buffer, which leaves no garbage behind.
+     *
+     * Time complexity: O(n + m), where n = number of rows, m = number of elements moved
+     */
+    template <class T, class Allocator, class Index>
+    template <class F>
+    size_t vector2d<T, Allocator, Index>::erase_rows_where(F&& remove, bool compact_data)
+    {
+        VECTOR2D_STATS(vector2d_stats::compaction_scope scope(m_stats, compact_data));
+        data_type data(m_data.get_allocator());
+        if (compact_data) { data.reserve(m_nelement); }
 
-                // Fill the new element.
-                m_container->m_data[m_container->m_data.size() - 1] = value;
+        size_t nkept = 0;
+        for (size_t i = 0; i < m_rows.size(); ++i)
+        {
+            row_record& row = m_rows[i];
+            if (remove(i, const_row_type(this, &row)))
+            {
+                if (compact_data) { m_nelement -= row.size(); }
+                else { this->release(row); }
+                continue;
             }
-            else
+
+            if (compact_data)
             {
-                m_container->m_data.emplace_back(value);
+                this->move_row(row, data);
             }
+            if (nkept != i) { m_rows[nkept] = row; }
+            ++nkept;
+        }
 
-            this->update(m_container->m_data.size() - this->size() - 1, this->size() + 1);
+        size_t const nerased = m_rows.size() - nkept;
+        m_rows.erase(m_rows.begin() + nkept, m_rows.end());
+
+        if (compact_data)
+        {
+            m_data.swap(data);
+            m_holes.clear();
+        }
+        else
+        {
+            this->auto_compact();
         }
+        return nerased;
     }
 
     /**
-     * There are 3 situations in resize():
-     * 1. Request smaller size: We only shrink the size and leave the remaining space as the capacity of this row.
-     * 2. Request bigger size and the capacity is enough: Fill the range of value in the capacity.
-     * 3. Request bigger size and the capacity is not enough, we append the size of elements to the end, then
-     *    move the original elements and fill the remaining elements with value.
-     *
-     * Time complexity: O(m), where m = size of the row plus reallocation if required.
+     * There are 2 situations in resize() of vector2d:
+     * 1. Request smaller size: We only resize the row vector, and give the memory of deleted rows back to the free space.
+     * 2. Request bigger size: We append n (size) * m (nelement of row) elements to m_data, and update the index of rows.
      */
-    template <class T>
-    void vector2d<T>::row_type::resize(size_t size, T const& value)
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::resize(size_t size, const_row_type row)
     {
-        if (size <= this->size())
+        size_t const nrow = m_rows.size();
+
+        if (size <= nrow)
         {
-            // Reduce the size but keep the capacity as before.
-            this->update(this->begin_index(), size);
+            this->resize(size);
             return;
         }
 
-        if (size <= this->capacity())
+        size_t const diff = size - nrow;
+        this->check_growth(m_data.size(), diff, row.size());
+        size_t const extra = diff * row.size();
+
+        // Append n (size) * m (row.size()) elements of value type to m_data.
+        // The row might belong to this container, so m_data is filled before growing m_rows.
+        this->reserve_data(extra);
+
+        size_t const count = row.size();
+        size_t const begin_index = m_data.size();
+        for (size_t i = nrow; i < size; ++i)
         {
-            for (size_t i = this->end_index(); i < this->end_index() + size - this->size(); ++i)
+            for (auto it = row.begin(); it != row.end(); ++it)
             {
-                m_container->m_data[i] = value;
+                m_data.emplace_back(*it);
             }
-            this->update(this->begin_index(), size);
         }
-        else
-        {
-            m_container->append(size, value);
-
-            if (!this->empty())
-            {
-                m_container->move_desc(this->begin_index(),
-                    this->begin_index() + this->size(),
-                    m_container->m_data.size() - size);
-                // TODO: unused memory in the original position could be the capacity of previous/next row.
-                for (size_t i = m_container->m_data.size() - size + this->size(); i < m_container->m_data.size(); ++i)
-                {
-                    m_container->m_data[i] = value;
-                }
-            }
 
-            this->update(m_container->m_data.size() - size, size);
+        // Add new rows.
+        m_rows.reserve(size);
+        for (size_t i = nrow; i < size; ++i)
+        {
+            m_rows.emplace_back(begin_index + (i - nrow) * count, count);
         }
+        m_nelement += diff * count;
     }
 
-    template <class T>
-    void vector2d<T>::push_back(std::initializer_list<T> const& arr)
+    /**
+     * The rows are sorted by begin index, so every row is moved to a lower or the same position, which never
+     * overwrites the elements of rows not moved yet. Then the tail of m_data is removed.
+     *
+     * Time complexity: O(n log n + m), where n = number of rows, m = size of m_data.
+     */
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::compact_in_place()
     {
-        auto nelement = arr.end() - arr.begin();
-        // Add new row
-        m_rows.emplace_back(this, m_data.size(), nelement, typename row_type::ctor_passkey());
-        // Insert range data to m_data
-        m_data.reserve(m_data.size() + nelement);
-
-        for (auto it = arr.begin(); it != arr.end(); ++it)
+        // Every row is laid out again, the rows without capacity as well.
+        std::vector<size_t> order(m_rows.size());
+        std::iota(order.begin(), order.end(), size_t(0));
+        std::sort(order.begin(), order.end(),
+            [this](size_t a, size_t b) { return m_rows[a].begin_index() < m_rows[b].begin_index(); });
+
+        size_t ibegin = 0;
+        for (size_t i : order)
         {
-            m_data.emplace_back(*it);
+            row_record& row = m_rows[i];
+            if (!row.empty() && row.begin_index() != ibegin) { this->move_asc(row.begin_index(), row.end_index(), ibegin); }
+            row.relayout(ibegin);
+            ibegin += row.size();
         }
+
+        m_data.erase(m_data.begin() + ibegin, m_data.end());
+        m_data.shrink_to_fit();
+        m_holes.clear();
     }
 
-    template <class T>
-    void vector2d<T>::push_back(std::vector<T> const& arr)
+    /**
+     * The plan is the rows which have capacity, sorted by begin index. Row k of the plan is moved to the frontier,
+     * the end of the compacted region, if the space between them is one hole; the row and the hole are then given
+     * back as one hole after the row, which the next row of the plan moves into. Each row of the plan records its
+     * layout at planning time, so any change of the layout between steps is detected as a mismatch and the rest
+     * of the step plans again.
+     */
+    template <class T, class Allocator, class Index>
+    template <class Stop>
+    bool vector2d<T, Allocator, Index>::compact_steps(Stop&& stop)
     {
-        auto nelement = arr.end() - arr.begin();
-        // Add new row
-        m_rows.emplace_back(this, m_data.size(), nelement, typename row_type::ctor_passkey());
-        // Insert range data to m_data
-        m_data.reserve(m_data.size() + nelement);
+        if (m_holes.empty() && this->nspare() == 0)
+        {
+            m_step_plan.clear();
+            return true;
+        }
+        VECTOR2D_STATS(vector2d_stats::compaction_scope scope(m_stats));
 
-        for (auto it = arr.begin(); it != arr.end(); ++it)
+        bool planned = false;
+        for (;;)
         {
-            m_data.emplace_back(*it);
+            if (m_step_next == m_step_plan.size())
+            {
+                if (planned) { break; }
+                this->plan_compact_steps();
+                planned = true;
+                continue;
+            }
+            if (!this->compact_next_row())
+            {
+                // The layout changed, plan again only once per step so that a step always ends.
+                if (planned) { break; }
+                this->plan_compact_steps();
+                planned = true;
+                continue;
+            }
+            // The row of the entry just moved is in range, compact_next_row() has checked it.
+            if (stop(m_rows[m_step_plan[m_step_next - 1].index].size())) { break; }
+        }
+
+        bool const done = m_holes.empty() && this->nspare() == 0;
+        if (done || m_step_next == m_step_plan.size())
+        {
+            m_step_plan.clear();
+            m_step_next = 0;
         }
+        return done;
     }
 
-    template <class T>
-    typename std::vector<typename vector2d<T>::row_type>::iterator
-        vector2d<T>::insert(const_row_iterator pos, row_iterator first, row_iterator last)
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::plan_compact_steps()
     {
-        row_iterator rit;
-        size_t const diff = pos - begin();
-        for (auto it = last - 1; it != first - 1; --it) { rit = this->insert(begin() + diff, *it); }
-        return rit;
+        m_step_plan.clear();
+        for (size_t i = 0; i < m_rows.size(); ++i)
+        {
+            row_record const& row = m_rows[i];
+            if (row.capacity() != 0) { m_step_plan.push_back(compact_plan_entry{ i, row.begin_index(), row.capacity() }); }
+        }
+        std::sort(m_step_plan.begin(), m_step_plan.end(),
+            [](compact_plan_entry const& a, compact_plan_entry const& b) { return a.ibegin < b.ibegin; });
+        m_step_next = 0;
+        m_step_frontier = 0;
     }
 
-    template <class T>
-    typename std::vector<typename vector2d<T>::row_type>::iterator
-        vector2d<T>::insert(row_iterator pos, row_type const& row)
+    template <class T, class Allocator, class Index>
+    bool vector2d<T, Allocator, Index>::compact_next_row()
     {
-        row_type tmp_row = row_type(this, typename row_type::ctor_passkey());
-        tmp_row.update(m_data.size(), row.size());
-        m_data.reserve(m_data.size() + row.size());
-
-        for (auto it = row.begin(); it != row.end(); ++it)
+        compact_plan_entry const& entry = m_step_plan[m_step_next];
+        if (entry.index >= m_rows.size()) { return false; }
+        row_record& row = m_rows[entry.index];
+        if (row.begin_index() != entry.ibegin || row.capacity() != entry.capacity) { return false; }
+
+        // The space between the frontier and the row has to be exactly one hole.
+        size_t const ibegin = m_step_frontier;
+        if (entry.ibegin < ibegin) { return false; }
+        size_t const gap = entry.ibegin - ibegin;
+        if (gap != 0)
         {
-            m_data.emplace_back(*it);
+            auto const it = m_holes.holes().find(ibegin);
+            if (it == m_holes.holes().end() || it->second != gap) { return false; }
+            m_holes.take(ibegin, gap);
+            this->move_asc(entry.ibegin, entry.ibegin + row.size(), ibegin);
         }
+        row.relayout(ibegin);
+        this->deallocate(ibegin + row.size(), gap + entry.capacity - row.size());
+
+        m_step_frontier = ibegin + row.size();
+        ++m_step_next;
+        return true;
+    }
+
+    /**
+     * The rows are split into nchunk chunks of adjacent rows. The first pass sums the sizes of rows in each
+     * chunk, and the exclusive scan of these sums is the begin index of each chunk in the new buffer. The
+     * second pass moves each chunk from its begin index, so no chunk depends on the others.
+     */
+    template <class T, class Allocator, class Index>
+    template <class ForEachChunk>
+    void vector2d<T, Allocator, Index>::compact_parallel(size_t nchunk, ForEachChunk&& for_each_chunk)
+    {
+        VECTOR2D_STATS(vector2d_stats::compaction_scope scope(m_stats));
+        size_t const nrow = m_rows.size();
+        nchunk = std::max<size_t>(std::min(nchunk, nrow), 1);
+        auto const chunk_begin = [nrow, nchunk](size_t i) { return nrow * i / nchunk; };
 
-        row_iterator rit = m_rows.insert(pos, tmp_row);
+        std::vector<size_t> ibegins(nchunk + 1, 0);
+        for_each_chunk(nchunk, [&](size_t i)
+            {
+                size_t count = 0;
+                for (size_t n = chunk_begin(i); n < chunk_begin(i + 1); ++n) { count += m_rows[n].size(); }
+                ibegins[i + 1] = count;
+            });
+        std::partial_sum(ibegins.begin(), ibegins.end(), ibegins.begin());
+
+        data_type data(m_nelement, m_data.get_allocator());
+        for_each_chunk(nchunk, [&](size_t i)
+            {
+                size_t ibegin = ibegins[i];
+                for (size_t n = chunk_begin(i); n < chunk_begin(i + 1); ++n)
+                {
+                    row_record& row = m_rows[n];
+                    if (!row.empty()) { std::move(m_data.begin() + row.begin_index(), m_data.begin() + row.end_index(), data.begin() + ibegin); }
+                    row.relayout(ibegin);
+                    ibegin += row.size();
+                }
+            });
 
-        return rit;
+        m_data.swap(data);
+        m_holes.clear();
     }
 
-    // TODO: unused memory could be the capacity of previous/next Row.
-    template <class T>
-    typename std::vector<typename vector2d<T>::row_type>::iterator
-        vector2d<T>::erase(const_row_iterator first, const_row_iterator last)
+    /**
+     * counts[c * ncol + j] is the number of elements j in chunk c, which the scan turns into the write offset of
+     * chunk c in row j of the result. The chunks before c write their elements first, so the elements of each
+     * result row are in the order of rows. The invalid elements are recorded by the chunks and thrown after the
+     * first pass, since the execution policies don't propagate exceptions.
+     */
+    template <class T, class Allocator, class Index>
+    template <class ForEachChunk>
+    vector2d<T, Allocator, Index> vector2d<T, Allocator, Index>::transpose_parallel(size_t ncol, size_t nchunk,
+        ForEachChunk&& for_each_chunk) const
     {
-        size_t const fdiff = first - this->begin();
-        if (fdiff > this->size() || fdiff < 0)
+        static_assert(std::is_integral<T>::value, "vector2d::transpose() requires integral elements");
+
+        size_t const nrow = m_rows.size();
+        if (nrow != 0 && nrow - 1 > static_cast<std::make_unsigned_t<T>>(std::numeric_limits<T>::max()))
         {
             std::ostringstream ms;
-            ms << "ollib::vector2d::erase(): input fisrt " << fdiff << " is out of range.";
+            ms << "ollib::vector2d::transpose(): " << nrow << " rows don't fit in the element type.";
             throw std::out_of_range(ms.str());
         }
 
-        size_t const ldiff = last - this->begin();
-        if (ldiff > this->size() || ldiff < 0)
+        // The counts of each chunk take ncol elements, keep them no larger than the elements.
+        nchunk = std::max<size_t>(std::min({ nchunk, nrow, ncol == 0 ? size_t(1) : m_nelement / ncol }), 1);
+        auto const chunk_begin = [nrow, nchunk](size_t i) { return nrow * i / nchunk; };
+
+        std::vector<size_t> counts(nchunk * ncol, 0);
+        std::vector<size_t> invalid(nchunk, hole_map::npos);
+        for_each_chunk(nchunk, [&](size_t i)
+            {
+                size_t* const count = counts.data() + i * ncol;
+                for (size_t n = chunk_begin(i); n < chunk_begin(i + 1) && invalid[i] == hole_map::npos; ++n)
+                {
+                    for (T const& value : this->row_span(n))
+                    {
+                        // A negative value converts to an index beyond any ncol which fits in memory.
+                        size_t const j = static_cast<size_t>(value);
+                        if (j >= ncol)
+                        {
+                            invalid[i] = n;
+                            break;
+                        }
+                        ++count[j];
+                    }
+                }
+            });
+        for (size_t n : invalid)
         {
+            if (n == hole_map::npos) { continue; }
             std::ostringstream ms;
-            ms << "ollib::vector2d::erase(): input last " << ldiff << " is out of range.";
+            ms << "ollib::vector2d::transpose(): row " << n << " has an element out of range [0, " << ncol << ").";
             throw std::out_of_range(ms.str());
         }
 
-        size_t const range = last - first;
-        if (range < 0)
+        std::vector<size_t> offsets(ncol + 1, 0);
+        size_t offset = 0;
+        for (size_t j = 0; j < ncol; ++j)
         {
-            std::ostringstream ms;
-            ms << "ollib::vector2d::erase(): input range is invalid.";
-            throw std::out_of_range(ms.str());
+            for (size_t i = 0; i < nchunk; ++i)
+            {
+                size_t const count = counts[i * ncol + j];
+                counts[i * ncol + j] = offset;
+                offset += count;
+            }
+            offsets[j + 1] = offset;
         }
 
-        // Return last if first==last.
-        if (range == 0) { return this->begin() + ldiff; }
+        data_type values(m_nelement, T(), m_data.get_allocator());
+        for_each_chunk(nchunk, [&](size_t i)
+            {
+                size_t* const cursor = counts.data() + i * ncol;
+                for (size_t n = chunk_begin(i); n < chunk_begin(i + 1); ++n)
+                {
+                    for (T const& value : this->row_span(n)) { values[cursor[static_cast<size_t>(value)]++] = static_cast<T>(n); }
+                }
+            });
 
-        for (auto it = this->begin() + fdiff; it != this->begin() + ldiff; ++it) { it->clear(); }
+        return vector2d(offsets, std::move(values));
+    }
 
-        row_iterator rit = m_rows.erase(first, last);
+    template <class T, class Allocator, class Index>
+    template <typename U>
+    std::vector<std::span<U>> vector2d<T, Allocator, Index>::element_runs() const
+    {
+        std::vector<std::pair<size_t, size_t>> ranges;
+        ranges.reserve(m_rows.size());
+        for (auto const& row : m_rows)
+        {
+            if (!row.empty()) { ranges.emplace_back(row.begin_index(), row.end_index()); }
+        }
+        if (!std::is_sorted(ranges.begin(), ranges.end())) { std::sort(ranges.begin(), ranges.end()); }
 
-        return rit;
+        std::vector<std::span<U>> runs;
+        U* const data = const_cast<U*>(m_data.data());
+        for (auto const& range : ranges)
+        {
+            if (!runs.empty() && runs.back().data() + runs.back().size() == data + range.first)
+            {
+                runs.back() = std::span<U>(runs.back().data(), runs.back().size() + (range.second - range.first));
+            }
+            else
+            {
+                runs.emplace_back(data + range.first, range.second - range.first);
+            }
+        }
+        return runs;
     }
 
-    template <class T>
-    typename std::vector<typename vector2d<T>::row_type>::iterator
-        vector2d<T>::erase(const_row_iterator pos)
+    template <class T, class Allocator, class Index>
+    size_t vector2d<T, Allocator, Index>::allocate(size_t count)
     {
-        size_t const diff = pos - begin();
-        return this->erase(begin() + diff, begin() + diff + 1);
+        size_t const ibegin = m_holes.acquire(count);
+        if (ibegin != hole_map::npos) { return ibegin; }
+
+        this->append(count, T());
+        return m_data.size() - count;
     }
 
-    /**
-     * There are 2 situations in resize() of vector2d:
-     * 1. Request smaller size: We only resize the row vector, leave the momory deleted row as garbage.
-     * 2. Request bigger size: We append n (size) * m (nelement of row) elements to m_data, and update the index of rows.
-     */
-    template <class T>
-    void vector2d<T>::resize(size_t size, row_type const& row)
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::deallocate(size_t ibegin, size_t count)
     {
-        size_t const nrow = m_rows.size();
-        row_type r = row;
-        r.reset(this);
-        m_rows.resize(size, r);
+        if (count == 0) { return; }
 
-        if (size <= nrow) { return; }
+        if (ibegin + count != m_data.size())
+        {
+            m_holes.insert(ibegin, count);
+            return;
+        }
 
-        size_t const diff = size - nrow;
-        size_t const extra = diff * row.size();
-        size_t const total = m_data.size() + extra;
+        // Remove the range and the hole right before it from the end of m_data.
+        size_t const itail = m_holes.pop_back(ibegin);
+        m_data.erase(m_data.begin() + (itail == hole_map::npos ? ibegin : itail), m_data.end());
+    }
 
-        // Append n (size) * m (row.size()) elements of value type to m_data.
-        m_data.reserve(total);
+    template <class T, class Allocator, class Index>
+    template <class InputIt>
+    size_t vector2d<T, Allocator, Index>::store(InputIt first, InputIt last)
+    {
+        size_t const count = std::distance(first, last);
+        if (count == 0) { return m_data.size(); }
 
-        // Update new rows.
-        size_t const begin_index = m_data.size();
-        for (size_t i = nrow; i < size; ++i)
+        size_t const ibegin = m_holes.acquire(count);
+        if (ibegin != hole_map::npos)
         {
-            size_t index = begin_index + (i - nrow) * row.size();
-            m_rows[i].update(index, row.size());
+            std::copy(first, last, m_data.begin() + ibegin);
+            return ibegin;
+        }
 
-            for (auto it = row.begin(); it != row.end(); ++it)
+        this->reserve_data(count);
+        for (auto it = first; it != last; ++it)
+        {
+            m_data.emplace_back(*it);
+        }
+        return m_data.size() - count;
+    }
+
+    template <class T, class Allocator, class Index>
+    void vector2d<T, Allocator, Index>::hole_map::insert(size_t ibegin, size_t count)
+    {
+        if (count == 0) { return; }
+
+        size_t const iend = ibegin + count;
+        auto next = m_by_begin.lower_bound(ibegin);
+
+        // Merge with the previous hole.
+        if (next != m_by_begin.begin())
+        {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == ibegin)
             {
-                m_data.emplace_back(*it);
+                ibegin = prev->first;
+                this->erase(prev);
             }
         }
+
+        // Merge with the next hole.
+        size_t size = iend - ibegin;
+        if (next != m_by_begin.end() && next->first == iend)
+        {
+            size += next->second;
+            this->erase(next);
+        }
+
+        this->emplace(ibegin, size);
+    }
+
+    template <class T, class Allocator, class Index>
+    size_t vector2d<T, Allocator, Index>::hole_map::acquire(size_t count)
+    {
+        auto it = m_by_size.lower_bound(std::make_pair(count, size_t(0)));
+        if (count == 0 || it == m_by_size.end()) { return npos; }
+
+        size_t const size = it->first;
+        size_t const ibegin = it->second;
+        this->erase(m_by_begin.find(ibegin));
+        if (size > count) { this->emplace(ibegin + count, size - count); }
+
+        return ibegin;
+    }
+
+    template <class T, class Allocator, class Index>
+    bool vector2d<T, Allocator, Index>::hole_map::take(size_t ibegin, size_t count)
+    {
+        auto it = m_by_begin.find(ibegin);
+        if (it == m_by_begin.end() || it->second < count) { return false; }
+
+        size_t const size = it->second;
+        this->erase(it);
+        if (size > count) { this->emplace(ibegin + count, size - count); }
+
+        return true;
+    }
+
+    template <class T, class Allocator, class Index>
+    size_t vector2d<T, Allocator, Index>::hole_map::pop_back(size_t iend)
+    {
+        if (m_by_begin.empty()) { return npos; }
+
+        auto it = std::prev(m_by_begin.end());
+        if (it->first + it->second != iend) { return npos; }
+
+        size_t const ibegin = it->first;
+        this->erase(it);
+
+        return ibegin;
     }
 
-    template <class T>
-    inline void vector2d<T>::append(size_t count, T const& value)
+    template <class T, class Allocator, class Index>
+    inline void vector2d<T, Allocator, Index>::append(size_t count, T const& value)
     {
+        this->check_growth(m_data.size(), count);
+        VECTOR2D_STATS(size_t const old_capacity = m_data.capacity());
         m_data.resize(m_data.size() + count, value);
+        VECTOR2D_STATS(this->count_reallocation(old_capacity));
     }
 
-    template <class T>
-    inline void vector2d<T>::move_desc(size_t ibegin, size_t iend, size_t new_ibegin)
+    template <class T, class Allocator, class Index>
+    inline void vector2d<T, Allocator, Index>::move_desc(size_t ibegin, size_t iend, size_t new_ibegin)
     {
-        for (int i = static_cast<int>(iend - ibegin); i >= 0; --i)
-        {
-            m_data[new_ibegin + i] = std::move(m_data[ibegin + i]);
-        }
+        if (ibegin >= iend || ibegin == new_ibegin) { return; }
+        VECTOR2D_STATS(m_stats.moved_elements += iend - ibegin);
+        this->move_desc(ibegin, iend, new_ibegin, std::is_trivially_copyable<T>());
     }
 
-    template <class T>
-    inline void vector2d<T>::move_asc(size_t ibegin, size_t iend, size_t new_ibegin)
+    template <class T, class Allocator, class Index>
+    inline void vector2d<T, Allocator, Index>::move_asc(size_t ibegin, size_t iend, size_t new_ibegin)
     {
-        for (int i = 0; i < static_cast<int>(iend - ibegin); ++i)
-        {
-            m_data[new_ibegin + i] = std::move(m_data[ibegin + i]);
-        }
+        if (ibegin >= iend || ibegin == new_ibegin) { return; }
+        VECTOR2D_STATS(m_stats.moved_elements += iend - ibegin);
+        this->move_asc(ibegin, iend, new_ibegin, std::is_trivially_copyable<T>());
+    }
+
+    template <class T, class Allocator, class Index>
+    inline void vector2d<T, Allocator, Index>::move_desc(size_t ibegin, size_t iend, size_t new_ibegin, std::true_type)
+    {
+        std::memmove(m_data.data() + new_ibegin, m_data.data() + ibegin, (iend - ibegin) * sizeof(T));
+    }
+
+    template <class T, class Allocator, class Index>
+    inline void vector2d<T, Allocator, Index>::move_desc(size_t ibegin, size_t iend, size_t new_ibegin, std::false_type)
+    {
+        std::move_backward(m_data.begin() + ibegin, m_data.begin() + iend, m_data.begin() + new_ibegin + (iend - ibegin));
+    }
+
+    template <class T, class Allocator, class Index>
+    inline void vector2d<T, Allocator, Index>::move_asc(size_t ibegin, size_t iend, size_t new_ibegin, std::true_type)
+    {
+        std::memmove(m_data.data() + new_ibegin, m_data.data() + ibegin, (iend - ibegin) * sizeof(T));
+    }
+
+    template <class T, class Allocator, class Index>
+    inline void vector2d<T, Allocator, Index>::move_asc(size_t ibegin, size_t iend, size_t new_ibegin, std::false_type)
+    {
+        std::move(m_data.begin() + ibegin, m_data.begin() + iend, m_data.begin() + new_ibegin);
+    }
+
+    namespace pmr
+    {
+        template <typename T, typename Index = size_t>
+        using vector2d = std::vector2d<T, std::pmr::polymorphic_allocator<T>, Index>;
     }
 
 }  // namespace ollib
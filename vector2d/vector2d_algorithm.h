@@ -0,0 +1,632 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "vector2d.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace std
+{
+
+    /**
+     * The segmented kernels over all rows of a vector2d, which write one output per row into a contiguous
+     * range out of size() elements, e.g. std::vector<double> or std::span<float>. The rows are taken as raw
+     * spans of the buffer, and the sums keep span_lanes independent accumulators per row so that the compiler
+     * maps them to SIMD lanes, while a row shorter than two rounds of lanes is added in one chain. So the
+     * floating point sums of long rows are added in a different order from a plain loop.
+     *
+     * The overloads with a thread_pool split the rows into chunks of adjacent rows, and each output is
+     * written by one thread. transform_rows() ignores the row boundaries and runs over the contiguous runs
+     * of elements, so short rows are batched into long loops.
+     */
+
+    // Call fn(first, last) for the chunks of rows [first, last) on the threads of pool.
+    template <class F>
+    void for_each_row_range(thread_pool& pool, size_t nrow, F&& fn)
+    {
+        size_t const nchunk = std::min(nrow, pool.size() * 4);
+        pool.parallel_for(nchunk, [nrow, nchunk, &fn](size_t i) { fn(nrow * i / nchunk, nrow * (i + 1) / nchunk); });
+    }
+
+    // The number of independent accumulators of the span kernels.
+    inline constexpr size_t span_lanes = 4;
+
+    // The sum of n elements by span_lanes lanes.
+    template <typename Out, typename T>
+    Out span_sum(T const* data, size_t n) noexcept
+    {
+        Out s0{}, s1{}, s2{}, s3{};
+        size_t i = 0;
+        if (n < span_lanes * 2)
+        {
+            // A short row is added in one chain, merging the lanes would cost more than it saves.
+            for (; i < n; ++i) { s0 += static_cast<Out>(data[i]); }
+            return s0;
+        }
+        for (; i + span_lanes <= n; i += span_lanes)
+        {
+            s0 += static_cast<Out>(data[i]);
+            s1 += static_cast<Out>(data[i + 1]);
+            s2 += static_cast<Out>(data[i + 2]);
+            s3 += static_cast<Out>(data[i + 3]);
+        }
+        for (; i < n; ++i) { s0 += static_cast<Out>(data[i]); }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    // The sum of data[i] * x[i] of n elements by span_lanes lanes.
+    template <typename Out, typename T, typename X>
+    Out span_dot(T const* data, X const* x, size_t n) noexcept
+    {
+        Out s0{}, s1{}, s2{}, s3{};
+        size_t i = 0;
+        if (n < span_lanes * 2)
+        {
+            for (; i < n; ++i) { s0 += static_cast<Out>(data[i]) * static_cast<Out>(x[i]); }
+            return s0;
+        }
+        for (; i + span_lanes <= n; i += span_lanes)
+        {
+            s0 += static_cast<Out>(data[i]) * static_cast<Out>(x[i]);
+            s1 += static_cast<Out>(data[i + 1]) * static_cast<Out>(x[i + 1]);
+            s2 += static_cast<Out>(data[i + 2]) * static_cast<Out>(x[i + 2]);
+            s3 += static_cast<Out>(data[i + 3]) * static_cast<Out>(x[i + 3]);
+        }
+        for (; i < n; ++i) { s0 += static_cast<Out>(data[i]) * static_cast<Out>(x[i]); }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    // The minimum or the maximum of n elements by span_lanes lanes, which is init if n is zero.
+    template <typename T, typename Less>
+    T span_extreme(T const* data, size_t n, T init, Less less) noexcept
+    {
+        T m0 = init, m1 = init, m2 = init, m3 = init;
+        size_t i = 0;
+        for (; i + span_lanes <= n; i += span_lanes)
+        {
+            m0 = less(data[i], m0) ? data[i] : m0;
+            m1 = less(data[i + 1], m1) ? data[i + 1] : m1;
+            m2 = less(data[i + 2], m2) ? data[i + 2] : m2;
+            m3 = less(data[i + 3], m3) ? data[i + 3] : m3;
+        }
+        for (; i < n; ++i) { m0 = less(data[i], m0) ? data[i] : m0; }
+        m0 = less(m1, m0) ? m1 : m0;
+        m2 = less(m3, m2) ? m3 : m2;
+        return less(m2, m0) ? m2 : m0;
+    }
+
+    /**
+     * The set operations of sorted spans, which write the result to out and return its size. The elements
+     * are compared by operator<, and repeated elements are kept as by std::set_intersection, std::set_union
+     * and std::merge. The intersection looks up each element of the shorter span in the longer one, by a
+     * galloping search if the longer one is span_gallop_ratio times longer, otherwise by skipping blocks of
+     * span_block elements and counting the elements less than the key in the last block without branches.
+     * The union copies the runs of one span below the head of the other one by the same block search.
+     *
+     * out of span_intersect() could be a or b, and out of span_union() or span_merge() could overlap a if
+     * out + nb <= a, the row operations below use that to work within the output.
+     *
+     * Time complexity: O(na + nb), or O(n * log(N / n)) for the galloping intersection, where n and N are the
+     * sizes of the shorter and the longer span
+     */
+
+    // The number of elements compared at once by span_lower_bound().
+    inline constexpr size_t span_block = span_lanes * 2;
+    // The ratio of sizes from which span_intersect() gallops in the longer span.
+    inline constexpr size_t span_gallop_ratio = 32;
+
+    // The first position in [first, n) of sorted data whose element isn't less than value.
+    template <typename T>
+    size_t span_lower_bound(T const* data, size_t first, size_t n, T const& value) noexcept
+    {
+        while (first + span_block <= n && data[first + span_block - 1] < value) { first += span_block; }
+        size_t const last = std::min(first + span_block, n);
+        size_t count = 0;
+        for (size_t i = first; i < last; ++i) { count += data[i] < value ? 1 : 0; }
+        return first + count;
+    }
+
+    // The same as span_lower_bound() by doubling the step from first, then a binary search in the last step.
+    template <typename T>
+    size_t span_gallop(T const* data, size_t first, size_t n, T const& value) noexcept
+    {
+        if (first == n || !(data[first] < value)) { return first; }
+        size_t low = first;
+        size_t step = 1;
+        while (low + step < n && data[low + step] < value)
+        {
+            low += step;
+            step *= 2;
+        }
+        return std::lower_bound(data + low + 1, data + std::min(low + step, n), value) - data;
+    }
+
+    template <typename T>
+    size_t span_intersect(T const* a, size_t na, T const* b, size_t nb, T* out) noexcept
+    {
+        if (na > nb)
+        {
+            std::swap(a, b);
+            std::swap(na, nb);
+        }
+        bool const gallop = nb >= na * span_gallop_ratio;
+        size_t count = 0;
+        for (size_t i = 0, j = 0; i < na && j < nb; ++i)
+        {
+            j = gallop ? span_gallop(b, j, nb, a[i]) : span_lower_bound(b, j, nb, a[i]);
+            if (j < nb && !(a[i] < b[j]))
+            {
+                out[count++] = a[i];
+                ++j;
+            }
+        }
+        return count;
+    }
+
+    template <typename T>
+    size_t span_union(T const* a, size_t na, T const* b, size_t nb, T* out) noexcept
+    {
+        size_t i = 0, j = 0, count = 0;
+        while (i < na && j < nb)
+        {
+            if (a[i] < b[j])
+            {
+                for (size_t const last = span_lower_bound(a, i, na, b[j]); i < last; ++i) { out[count++] = a[i]; }
+            }
+            else if (b[j] < a[i])
+            {
+                for (size_t const last = span_lower_bound(b, j, nb, a[i]); j < last; ++j) { out[count++] = b[j]; }
+            }
+            else
+            {
+                out[count++] = a[i];
+                ++i;
+                ++j;
+            }
+        }
+        for (; i < na; ++i) { out[count++] = a[i]; }
+        for (; j < nb; ++j) { out[count++] = b[j]; }
+        return count;
+    }
+
+    template <typename T>
+    size_t span_merge(T const* a, size_t na, T const* b, size_t nb, T* out) noexcept
+    {
+        size_t i = 0, j = 0, count = 0;
+        while (i < na && j < nb) { out[count++] = b[j] < a[i] ? b[j++] : a[i++]; }
+        for (; i < na; ++i) { out[count++] = a[i]; }
+        for (; j < nb; ++j) { out[count++] = b[j]; }
+        return count;
+    }
+
+    /**
+     * The loops of the row kernels over the rows [first, last), which write result[first, last).
+     */
+    class vector2d_kernel
+    {
+
+    public:
+
+        // The pointer to the output range, which has to hold one output per row.
+        template <class Rows, class OutRange>
+        static auto* output(Rows const& rows, OutRange& out, char const* func)
+        {
+            if (std::size(out) != rows.size())
+            {
+                std::ostringstream ms;
+                ms << "ollib::" << func << "(): output of " << std::size(out) << " elements doesn't match " << rows.size() << " rows.";
+                throw std::out_of_range(ms.str());
+            }
+            return std::data(out);
+        }
+
+        template <class Rows>
+        static void check_dense(Rows const& rows, size_t n, char const* func)
+        {
+            for (size_t i = 0; i < rows.size(); ++i)
+            {
+                if (rows.row_span(i).size() > n)
+                {
+                    std::ostringstream ms;
+                    ms << "ollib::" << func << "(): row " << i << " of " << rows.row_span(i).size() << " elements is longer than the input vector of "
+                        << n << " elements.";
+                    throw std::out_of_range(ms.str());
+                }
+            }
+        }
+
+        template <class Rows, class Out, typename Init, class Op>
+        static void reduce(Rows const& rows, size_t first, size_t last, Out* result, Init const& init, Op& op)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                auto const row = rows.row_span(i);
+                result[i] = std::accumulate(row.begin(), row.end(), init, op);
+            }
+        }
+
+        template <class Rows, class Out>
+        static void sum(Rows const& rows, size_t first, size_t last, Out* result)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                auto const row = rows.row_span(i);
+                result[i] = span_sum<Out>(row.data(), row.size());
+            }
+        }
+
+        template <class Rows, class Out>
+        static void mean(Rows const& rows, size_t first, size_t last, Out* result)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                auto const row = rows.row_span(i);
+                result[i] = row.empty() ? Out() : span_sum<Out>(row.data(), row.size()) / static_cast<Out>(row.size());
+            }
+        }
+
+        template <class Rows, class Out, typename T, class Less>
+        static void extreme(Rows const& rows, size_t first, size_t last, Out* result, T init, Less less)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                auto const row = rows.row_span(i);
+                result[i] = static_cast<Out>(span_extreme(row.data(), row.size(), init, less));
+            }
+        }
+
+        template <class Rows, typename X, class Out>
+        static void dot(Rows const& rows, size_t first, size_t last, X const* x, Out* result)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                auto const row = rows.row_span(i);
+                result[i] = span_dot<Out>(row.data(), x, row.size());
+            }
+        }
+
+        template <class Rows, class Pred, class Out>
+        static void count_if(Rows const& rows, size_t first, size_t last, Pred& pred, Out* result)
+        {
+            for (size_t i = first; i < last; ++i)
+            {
+                auto const row = rows.row_span(i);
+                size_t count = 0;
+                for (size_t j = 0; j < row.size(); ++j) { count += pred(row[j]) ? 1 : 0; }
+                result[i] = static_cast<Out>(count);
+            }
+        }
+
+        // The number of elements which the result of the set operation of the rows could hold, the smallest
+        // size of rows for the intersection, otherwise the total size.
+        template <class Rows, class IndexRange>
+        static size_t set_bound(Rows const& rows, IndexRange const& indices, bool intersection, char const* func)
+        {
+            size_t bound = 0;
+            bool first = true;
+            for (size_t const index : indices)
+            {
+                if (index >= rows.size())
+                {
+                    std::ostringstream ms;
+                    ms << "ollib::" << func << "(): input index " << index << " is out of range.";
+                    throw std::out_of_range(ms.str());
+                }
+                size_t const size = rows.row_span(index).size();
+                bound = intersection ? (first ? size : std::min(bound, size)) : bound + size;
+                first = false;
+            }
+            return bound;
+        }
+
+        template <class OutRange>
+        static auto* set_output(OutRange& out, size_t bound, char const* func)
+        {
+            if (std::size(out) < bound)
+            {
+                std::ostringstream ms;
+                ms << "ollib::" << func << "(): output of " << std::size(out) << " elements is shorter than the result of up to "
+                    << bound << " elements.";
+                throw std::out_of_range(ms.str());
+            }
+            return std::data(out);
+        }
+
+        // Intersect the shortest row first, then the others within out.
+        template <class Rows, class IndexRange, typename T>
+        static size_t intersect(Rows const& rows, IndexRange const& indices, T* out)
+        {
+            auto shortest = std::begin(indices);
+            for (auto it = std::begin(indices); it != std::end(indices); ++it)
+            {
+                if (rows.row_span(*it).size() < rows.row_span(*shortest).size()) { shortest = it; }
+            }
+            if (shortest == std::end(indices)) { return 0; }
+
+            auto const first = rows.row_span(*shortest);
+            size_t count = std::copy(first.begin(), first.end(), out) - out;
+            for (auto it = std::begin(indices); it != std::end(indices) && count != 0; ++it)
+            {
+                if (it == shortest) { continue; }
+                auto const row = rows.row_span(*it);
+                count = span_intersect(out, count, row.data(), row.size(), out);
+            }
+            return count;
+        }
+
+        /**
+         * The result so far is kept at the end of out[0, bound), and the next row is combined with it into
+         * the front of out, which never passes the unread part since the rows left take at least as much room.
+         * The result is moved back to the end unless it's the last row.
+         */
+        template <class Rows, class IndexRange, typename T, class Op>
+        static size_t combine(Rows const& rows, IndexRange const& indices, T* out, size_t bound, Op op)
+        {
+            auto it = std::begin(indices);
+            if (it == std::end(indices)) { return 0; }
+
+            auto const first = rows.row_span(*it);
+            if (++it == std::end(indices)) { return std::copy(first.begin(), first.end(), out) - out; }
+
+            size_t count = first.size();
+            std::copy(first.begin(), first.end(), out + bound - count);
+            while (true)
+            {
+                auto const row = rows.row_span(*it);
+                count = op(out + bound - count, count, row.data(), row.size(), out);
+                if (++it == std::end(indices)) { return count; }
+                if (count != bound) { std::copy_backward(out, out + count, out + bound); }
+            }
+        }
+
+        // Append the result of op(out) of up to bound elements to the row dest.
+        template <class Row, class Op>
+        static size_t append(Row& dest, size_t bound, Op op)
+        {
+            size_t const old = dest.size();
+            dest.resize(old + bound);
+            size_t const count = op(dest.data() + old);
+            dest.resize(old + count);
+            return count;
+        }
+
+    }; /* end class vector2d_kernel */
+
+    /**
+     * out[i] = op(... op(op(init, row[0]), row[1]) ..., row[k - 1]) of every row i, in the order of elements.
+     *
+     * Time complexity: O(n + m), or O(n / p + m / p) with a thread pool, where n = number of rows, m = number
+     * of elements, p = number of threads. The same for all the row kernels below.
+     */
+    template <typename T, typename Allocator, typename Index, class OutRange, typename Init, class Op>
+    void reduce_rows(vector2d<T, Allocator, Index> const& rows, OutRange&& out, Init init, Op op)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "reduce_rows");
+        vector2d_kernel::reduce(rows, 0, rows.size(), result, init, op);
+    }
+    template <typename T, typename Allocator, typename Index, class OutRange, typename Init, class Op>
+    void reduce_rows(thread_pool& pool, vector2d<T, Allocator, Index> const& rows, OutRange&& out, Init init, Op op)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "reduce_rows");
+        for_each_row_range(pool, rows.size(), [&](size_t first, size_t last) { vector2d_kernel::reduce(rows, first, last, result, init, op); });
+    }
+
+    // out[i] = the sum of row i, which is accumulated in the element type of out.
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    void row_sum(vector2d<T, Allocator, Index> const& rows, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_sum");
+        vector2d_kernel::sum(rows, 0, rows.size(), result);
+    }
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    void row_sum(thread_pool& pool, vector2d<T, Allocator, Index> const& rows, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_sum");
+        for_each_row_range(pool, rows.size(), [&](size_t first, size_t last) { vector2d_kernel::sum(rows, first, last, result); });
+    }
+
+    // out[i] = the mean of row i, the mean of an empty row is 0.
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    void row_mean(vector2d<T, Allocator, Index> const& rows, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_mean");
+        vector2d_kernel::mean(rows, 0, rows.size(), result);
+    }
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    void row_mean(thread_pool& pool, vector2d<T, Allocator, Index> const& rows, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_mean");
+        for_each_row_range(pool, rows.size(), [&](size_t first, size_t last) { vector2d_kernel::mean(rows, first, last, result); });
+    }
+
+    // out[i] = the minimum or the maximum of row i, which is the max() or the lowest() of T for an empty row.
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    void row_min(vector2d<T, Allocator, Index> const& rows, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_min");
+        vector2d_kernel::extreme(rows, 0, rows.size(), result, std::numeric_limits<T>::max(), std::less<T>());
+    }
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    void row_min(thread_pool& pool, vector2d<T, Allocator, Index> const& rows, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_min");
+        for_each_row_range(pool, rows.size(), [&](size_t first, size_t last)
+            { vector2d_kernel::extreme(rows, first, last, result, std::numeric_limits<T>::max(), std::less<T>()); });
+    }
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    void row_max(vector2d<T, Allocator, Index> const& rows, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_max");
+        vector2d_kernel::extreme(rows, 0, rows.size(), result, std::numeric_limits<T>::lowest(), std::greater<T>());
+    }
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    void row_max(thread_pool& pool, vector2d<T, Allocator, Index> const& rows, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_max");
+        for_each_row_range(pool, rows.size(), [&](size_t first, size_t last)
+            { vector2d_kernel::extreme(rows, first, last, result, std::numeric_limits<T>::lowest(), std::greater<T>()); });
+    }
+
+    // out[i] = the sum of row[j] * x[j] of row i, the dense range x, e.g. std::vector<double>, must be at least as long as every row.
+    template <typename T, typename Allocator, typename Index, class XRange, class OutRange>
+    void row_dot(vector2d<T, Allocator, Index> const& rows, XRange const& x, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_dot");
+        vector2d_kernel::check_dense(rows, std::size(x), "row_dot");
+        vector2d_kernel::dot(rows, 0, rows.size(), std::data(x), result);
+    }
+    template <typename T, typename Allocator, typename Index, class XRange, class OutRange>
+    void row_dot(thread_pool& pool, vector2d<T, Allocator, Index> const& rows, XRange const& x, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_dot");
+        vector2d_kernel::check_dense(rows, std::size(x), "row_dot");
+        for_each_row_range(pool, rows.size(), [&](size_t first, size_t last) { vector2d_kernel::dot(rows, first, last, std::data(x), result); });
+    }
+
+    // out[i] = the number of elements of row i for which pred(element) returns true.
+    template <typename T, typename Allocator, typename Index, class Pred, class OutRange>
+    void row_count_if(vector2d<T, Allocator, Index> const& rows, Pred pred, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_count_if");
+        vector2d_kernel::count_if(rows, 0, rows.size(), pred, result);
+    }
+    template <typename T, typename Allocator, typename Index, class Pred, class OutRange>
+    void row_count_if(thread_pool& pool, vector2d<T, Allocator, Index> const& rows, Pred pred, OutRange&& out)
+    {
+        auto* const result = vector2d_kernel::output(rows, out, "row_count_if");
+        for_each_row_range(pool, rows.size(), [&](size_t first, size_t last) { vector2d_kernel::count_if(rows, first, last, pred, result); });
+    }
+
+    /**
+     * Replace every element x of all rows by fn(x). The holes and the spare capacity of rows are skipped, and
+     * the overload with a thread pool splits the elements into equal ranges regardless of the rows.
+     *
+     * Time complexity: O(m), or O(m / p + r) with a thread pool, where m = number of elements, r = number of runs
+     * of elements, see vector2d::elements(), p = number of threads
+     */
+    template <typename T, typename Allocator, typename Index, class F>
+    void transform_rows(vector2d<T, Allocator, Index>& rows, F fn)
+    {
+        for (std::span<T> run : rows.elements()) { std::transform(run.begin(), run.end(), run.begin(), fn); }
+    }
+    template <typename T, typename Allocator, typename Index, class F>
+    void transform_rows(thread_pool& pool, vector2d<T, Allocator, Index>& rows, F fn)
+    {
+        std::vector<std::span<T>> const runs = rows.elements();
+        // ends[k] is the number of elements in the runs [0, k].
+        std::vector<size_t> ends(runs.size());
+        std::transform(runs.begin(), runs.end(), ends.begin(), [](std::span<T> run) { return run.size(); });
+        std::partial_sum(ends.begin(), ends.end(), ends.begin());
+
+        size_t const nelement = ends.empty() ? 0 : ends.back();
+        for_each_row_range(pool, nelement, [&](size_t first, size_t last)
+            {
+                size_t k = std::upper_bound(ends.begin(), ends.end(), first) - ends.begin();
+                for (size_t i = first; i < last; ++k)
+                {
+                    size_t const ibegin = ends[k] - runs[k].size();
+                    size_t const iend = std::min(ends[k], last);
+                    std::transform(runs[k].begin() + (i - ibegin), runs[k].begin() + (iend - ibegin), runs[k].begin() + (i - ibegin), fn);
+                    i = iend;
+                }
+            });
+    }
+
+
+    /**
+     * The set operations of the sorted rows of the given indices, e.g. sorted id lists, which write the result
+     * to out and return its size. out is a contiguous range of at least the smallest row size for the
+     * intersection, or of the total size of rows for the union and the merge, nothing else is allocated. The
+     * intersection of no rows is empty.
+     *
+     * append_intersection(), append_union() and append_merge() append the result to dest, a row of another
+     * vector2d, which grows once by that bound and shrinks to the result, so the capacity left is spare.
+     *
+     * Time complexity: O(k * m), where k = number of rows, m = number of elements of the rows, the intersection
+     * is usually less since it shrinks from the shortest row
+     */
+    template <typename T, typename Allocator, typename Index, class IndexRange, class OutRange>
+    size_t intersect_rows(vector2d<T, Allocator, Index> const& rows, IndexRange const& indices, OutRange&& out)
+    {
+        size_t const bound = vector2d_kernel::set_bound(rows, indices, true, "intersect_rows");
+        return vector2d_kernel::intersect(rows, indices, vector2d_kernel::set_output(out, bound, "intersect_rows"));
+    }
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    size_t intersect_rows(vector2d<T, Allocator, Index> const& rows, std::initializer_list<size_t> indices, OutRange&& out)
+    {
+        return intersect_rows<T, Allocator, Index, std::initializer_list<size_t>>(rows, indices, out);
+    }
+
+    template <typename T, typename Allocator, typename Index, class IndexRange, class OutRange>
+    size_t union_rows(vector2d<T, Allocator, Index> const& rows, IndexRange const& indices, OutRange&& out)
+    {
+        size_t const bound = vector2d_kernel::set_bound(rows, indices, false, "union_rows");
+        return vector2d_kernel::combine(rows, indices, vector2d_kernel::set_output(out, bound, "union_rows"), bound, span_union<T>);
+    }
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    size_t union_rows(vector2d<T, Allocator, Index> const& rows, std::initializer_list<size_t> indices, OutRange&& out)
+    {
+        return union_rows<T, Allocator, Index, std::initializer_list<size_t>>(rows, indices, out);
+    }
+
+    template <typename T, typename Allocator, typename Index, class IndexRange, class OutRange>
+    size_t merge_rows(vector2d<T, Allocator, Index> const& rows, IndexRange const& indices, OutRange&& out)
+    {
+        size_t const bound = vector2d_kernel::set_bound(rows, indices, false, "merge_rows");
+        return vector2d_kernel::combine(rows, indices, vector2d_kernel::set_output(out, bound, "merge_rows"), bound, span_merge<T>);
+    }
+    template <typename T, typename Allocator, typename Index, class OutRange>
+    size_t merge_rows(vector2d<T, Allocator, Index> const& rows, std::initializer_list<size_t> indices, OutRange&& out)
+    {
+        return merge_rows<T, Allocator, Index, std::initializer_list<size_t>>(rows, indices, out);
+    }
+
+    template <class Row, typename T, typename Allocator, typename Index, class IndexRange>
+    size_t append_intersection(Row dest, vector2d<T, Allocator, Index> const& rows, IndexRange const& indices)
+    {
+        size_t const bound = vector2d_kernel::set_bound(rows, indices, true, "append_intersection");
+        return vector2d_kernel::append(dest, bound, [&](T* out) { return vector2d_kernel::intersect(rows, indices, out); });
+    }
+    template <class Row, typename T, typename Allocator, typename Index>
+    size_t append_intersection(Row dest, vector2d<T, Allocator, Index> const& rows, std::initializer_list<size_t> indices)
+    {
+        return append_intersection<Row, T, Allocator, Index, std::initializer_list<size_t>>(dest, rows, indices);
+    }
+
+    template <class Row, typename T, typename Allocator, typename Index, class IndexRange>
+    size_t append_union(Row dest, vector2d<T, Allocator, Index> const& rows, IndexRange const& indices)
+    {
+        size_t const bound = vector2d_kernel::set_bound(rows, indices, false, "append_union");
+        return vector2d_kernel::append(dest, bound, [&](T* out) { return vector2d_kernel::combine(rows, indices, out, bound, span_union<T>); });
+    }
+    template <class Row, typename T, typename Allocator, typename Index>
+    size_t append_union(Row dest, vector2d<T, Allocator, Index> const& rows, std::initializer_list<size_t> indices)
+    {
+        return append_union<Row, T, Allocator, Index, std::initializer_list<size_t>>(dest, rows, indices);
+    }
+
+    template <class Row, typename T, typename Allocator, typename Index, class IndexRange>
+    size_t append_merge(Row dest, vector2d<T, Allocator, Index> const& rows, IndexRange const& indices)
+    {
+        size_t const bound = vector2d_kernel::set_bound(rows, indices, false, "append_merge");
+        return vector2d_kernel::append(dest, bound, [&](T* out) { return vector2d_kernel::combine(rows, indices, out, bound, span_merge<T>); });
+    }
+    template <class Row, typename T, typename Allocator, typename Index>
+    size_t append_merge(Row dest, vector2d<T, Allocator, Index> const& rows, std::initializer_list<size_t> indices)
+    {
+        return append_merge<Row, T, Allocator, Index, std::initializer_list<size_t>>(dest, rows, indices);
+    }
+
+}  // namespace ollib
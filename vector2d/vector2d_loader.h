@@ -0,0 +1,271 @@
+#pragma once
+
+#include "thread_pool.h"
+#include "vector2d.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <istream>
+#include <memory>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace std
+{
+
+    /**
+     * The text format read by text_loader: one row per line, the fields of a line are separated by delimiter
+     * and parsed by std::from_chars. The spaces and tabs around a field are skipped, and a delimiter of ' ' or
+     * '\t' splits the fields by any run of spaces and tabs. An empty line is an empty row, and "\r\n" line
+     * endings are accepted.
+     */
+    struct text_format
+    {
+        char delimiter = ',';
+        // The bytes read per chunk, a line longer than a chunk is read by several reads into one chunk.
+        size_t chunk_size = size_t(1) << 22;
+        // The most chunks which are read but not appended yet, 0 is twice the number of threads of the pool.
+        size_t max_chunks = 0;
+    };
+
+    /**
+     * The streaming loader of rows from a text stream in text_format. The stream is read in chunks which end
+     * at a line break by the calling thread, each chunk is parsed into its own staging buffer by a task of the
+     * pool, and the calling thread appends the parsed chunks in the order of the stream by one append_rows()
+     * per chunk. So reading, parsing and appending overlap, and at most max_chunks chunks are held at once.
+     */
+    template <typename T>
+    class text_loader
+    {
+        static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "text_loader requires arithmetic elements");
+
+    public:
+
+        explicit text_loader(thread_pool& pool, text_format const& format = text_format())
+            : m_pool(pool)
+            , m_format(format)
+        {
+            if (m_format.chunk_size == 0)
+            {
+                std::ostringstream ms;
+                ms << "ollib::text_loader(): input chunk_size " << m_format.chunk_size << " cannot be zero";
+                throw std::out_of_range(ms.str());
+            }
+        }
+
+        /**
+         * Append the rows of the stream or the file to rows, return the number of appended rows. If a field
+         * can't be parsed as T, std::runtime_error is thrown with the line number, and the rows of the chunks
+         * before the chunk of that line are kept in rows.
+         *
+         * Time complexity: O(b / p + m), where b = number of bytes, m = number of elements, p = number of threads
+         */
+        template <typename Allocator, typename Index>
+        size_t append(vector2d<T, Allocator, Index>& rows, std::istream& is) const;
+        template <typename Allocator, typename Index>
+        size_t append(vector2d<T, Allocator, Index>& rows, std::string const& path) const
+        {
+            std::ifstream is(path, std::ios::binary);
+            if (!is)
+            {
+                std::ostringstream ms;
+                ms << "ollib::text_loader::append(): failed to open " << path << ".";
+                throw std::runtime_error(ms.str());
+            }
+            return this->append(rows, is);
+        }
+
+        // Load the rows of the stream or the file into a new vector2d.
+        template <typename Allocator = std::allocator<T>, typename Index = size_t>
+        vector2d<T, Allocator, Index> load(std::istream& is, Allocator const& alloc = Allocator()) const
+        {
+            vector2d<T, Allocator, Index> rows(alloc);
+            this->append(rows, is);
+            return rows;
+        }
+        template <typename Allocator = std::allocator<T>, typename Index = size_t>
+        vector2d<T, Allocator, Index> load(std::string const& path, Allocator const& alloc = Allocator()) const
+        {
+            vector2d<T, Allocator, Index> rows(alloc);
+            this->append(rows, path);
+            return rows;
+        }
+
+    private:
+
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        // The rows parsed from a chunk of lines in the CSR format, or the first line which failed to parse.
+        struct chunk_type
+        {
+            std::vector<size_t> offsets{ 0 };
+            std::vector<T> values;
+            size_t nline = 0;
+            size_t error_line = npos;
+            std::string error_field;
+        };
+
+        static bool is_blank(char c) noexcept { return c == ' ' || c == '\t'; }
+
+        static chunk_type parse(std::string const& text, char delimiter);
+
+        thread_pool& m_pool;
+        text_format m_format;
+
+    }; /* end class text_loader */
+
+    // Load a vector2d from a text stream or file by a text_loader.
+    template <typename T, typename Allocator = std::allocator<T>, typename Index = size_t>
+    vector2d<T, Allocator, Index> load_text(std::istream& is, thread_pool& pool, text_format const& format = text_format(),
+        Allocator const& alloc = Allocator())
+    {
+        return text_loader<T>(pool, format).template load<Allocator, Index>(is, alloc);
+    }
+    template <typename T, typename Allocator = std::allocator<T>, typename Index = size_t>
+    vector2d<T, Allocator, Index> load_text(std::string const& path, thread_pool& pool, text_format const& format = text_format(),
+        Allocator const& alloc = Allocator())
+    {
+        return text_loader<T>(pool, format).template load<Allocator, Index>(path, alloc);
+    }
+
+    template <class T>
+    template <typename Allocator, typename Index>
+    size_t text_loader<T>::append(vector2d<T, Allocator, Index>& rows, std::istream& is) const
+    {
+        size_t const chunk_size = m_format.chunk_size;
+        size_t const max_chunks = m_format.max_chunks == 0 ? m_pool.size() * 2 : m_format.max_chunks;
+        char const delimiter = m_format.delimiter;
+        std::deque<std::future<chunk_type>> parsing;
+        size_t nline = 0;
+
+        // Append the oldest chunk in the order of the stream.
+        auto const append_front = [&]()
+        {
+            chunk_type const chunk = parsing.front().get();
+            parsing.pop_front();
+            if (chunk.error_line != npos)
+            {
+                std::ostringstream ms;
+                ms << "ollib::text_loader::append(): line " << nline + chunk.error_line + 1 << " has the invalid field \""
+                    << chunk.error_field << "\".";
+                throw std::runtime_error(ms.str());
+            }
+
+            std::vector<std::span<T const>> spans;
+            spans.reserve(chunk.nline);
+            for (size_t i = 0; i < chunk.nline; ++i)
+            {
+                spans.emplace_back(chunk.values.data() + chunk.offsets[i], chunk.offsets[i + 1] - chunk.offsets[i]);
+            }
+            rows.append_rows(spans);
+            nline += chunk.nline;
+        };
+
+        std::string pending;
+        for (bool eof = false; !eof;)
+        {
+            std::string text = std::move(pending);
+            pending.clear();
+            size_t const old = text.size();
+            text.resize(old + chunk_size);
+            is.read(text.data() + old, static_cast<std::streamsize>(chunk_size));
+            text.resize(old + static_cast<size_t>(is.gcount()));
+            if (is.bad())
+            {
+                std::ostringstream ms;
+                ms << "ollib::text_loader::append(): failed to read the stream after " << nline << " lines.";
+                throw std::runtime_error(ms.str());
+            }
+            eof = !is;
+
+            if (!eof)
+            {
+                // Carry the partial line at the end over to the next chunk.
+                size_t const last = text.rfind('\n');
+                if (last == std::string::npos)
+                {
+                    pending = std::move(text);
+                    continue;
+                }
+                pending.assign(text, last + 1, std::string::npos);
+                text.resize(last + 1);
+            }
+            if (text.empty()) { continue; }
+
+            // The task owns its text, so it's safe to outlive this call if appending throws.
+            auto task = std::make_shared<std::packaged_task<chunk_type()>>(
+                [text = std::move(text), delimiter]() { return text_loader::parse(text, delimiter); });
+            parsing.push_back(task->get_future());
+            m_pool.submit([task]() { (*task)(); });
+
+            while (!parsing.empty()
+                && (parsing.size() >= max_chunks || parsing.front().wait_for(std::chrono::seconds(0)) == std::future_status::ready))
+            {
+                append_front();
+            }
+        }
+        while (!parsing.empty()) { append_front(); }
+
+        return nline;
+    }
+
+    /**
+     * The fields of a line end at the delimiter, or at a space or a tab if the delimiter is blank. A line of
+     * blanks is an empty row, while an empty field between two delimiters fails to parse.
+     */
+    template <class T>
+    typename text_loader<T>::chunk_type text_loader<T>::parse(std::string const& text, char delimiter)
+    {
+        chunk_type chunk;
+        // A chunk of short numbers has about one value per two bytes.
+        chunk.values.reserve(text.size() / 2);
+        bool const blank_delimited = is_blank(delimiter);
+
+        char const* p = text.data();
+        char const* const end = text.data() + text.size();
+        while (p != end)
+        {
+            char const* eol = std::find(p, end, '\n');
+            char const* const next = eol == end ? end : eol + 1;
+            if (eol != p && *(eol - 1) == '\r') { --eol; }
+
+            for (char const* field = p; ;)
+            {
+                while (field != eol && is_blank(*field)) { ++field; }
+                if (field == eol && (blank_delimited || chunk.values.size() == chunk.offsets.back())) { break; }
+
+                char const* field_end = blank_delimited ? std::find_if(field, eol, is_blank) : std::find(field, eol, delimiter);
+                char const* const separator = field_end;
+                while (field_end != field && is_blank(*(field_end - 1))) { --field_end; }
+
+                T value{};
+                auto const result = std::from_chars(field, field_end, value);
+                if (result.ec != std::errc() || result.ptr != field_end)
+                {
+                    chunk.error_line = chunk.nline;
+                    chunk.error_field.assign(field, field_end);
+                    return chunk;
+                }
+                chunk.values.push_back(value);
+
+                if (separator == eol) { break; }
+                field = blank_delimited ? separator : separator + 1;
+            }
+
+            chunk.offsets.push_back(chunk.values.size());
+            ++chunk.nline;
+            p = next;
+        }
+        return chunk;
+    }
+
+}  // namespace ollib
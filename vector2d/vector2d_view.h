@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <sstream>
+#include <span>
+#include <stdexcept>
+
+namespace std
+{
+
+    /**
+     * The non-owning view of jagged rows stored as offsets and values, i.e. row i is
+     * values[offsets[i], offsets[i + 1]).
+     *
+     * The view neither allocates nor copies, so it can describe the data of export_csr(), of a
+     * mapped_vector2d or of any externally provided buffer. The rows are returned as std::span so
+     * that the same kernels run on all of them. The caller keeps both buffers alive while the view
+     * is used.
+     *
+     * @param T the element type, which is const for a read-only view
+     * @param Offset the offset type, e.g. size_t for export_csr() and uint64_t for the file format
+     */
+    template <typename T, typename Offset = size_t>
+    class vector2d_view
+    {
+
+    public:
+
+        using value_type = std::span<T>;
+        using element_type = T;
+        using offset_type = Offset;
+
+        /**
+         * The random access iterator over the rows, which is dereferenced to std::span<T>. Like the iterators of
+         * std::span, it refers to the offsets and the values, not to the view, so it outlives a temporary view.
+         */
+        class row_iterator
+        {
+
+        public:
+
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = std::span<T>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = std::span<T>;
+
+            row_iterator() = default;
+            row_iterator(Offset const* offsets, T* values, size_t index) noexcept : m_offsets(offsets), m_values(values), m_index(index) {}
+
+            reference operator*() const { return vector2d_view::row(m_offsets, m_values, m_index); }
+            reference operator[](difference_type n) const { return vector2d_view::row(m_offsets, m_values, m_index + n); }
+
+            row_iterator& operator++() { ++m_index; return *this; }
+            row_iterator operator++(int) { row_iterator old = *this; ++m_index; return old; }
+            row_iterator& operator--() { --m_index; return *this; }
+            row_iterator operator--(int) { row_iterator old = *this; --m_index; return old; }
+            row_iterator& operator+=(difference_type n) { m_index += n; return *this; }
+            row_iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+            row_iterator operator+(difference_type n) const { return row_iterator(m_offsets, m_values, m_index + n); }
+            row_iterator operator-(difference_type n) const { return row_iterator(m_offsets, m_values, m_index - n); }
+            friend row_iterator operator+(difference_type n, row_iterator const& it) { return it + n; }
+            difference_type operator-(row_iterator const& other) const
+            {
+                return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+            }
+
+            bool operator==(row_iterator const& other) const { return m_index == other.m_index; }
+            bool operator!=(row_iterator const& other) const { return m_index != other.m_index; }
+            bool operator<(row_iterator const& other) const { return m_index < other.m_index; }
+            bool operator>(row_iterator const& other) const { return m_index > other.m_index; }
+            bool operator<=(row_iterator const& other) const { return m_index <= other.m_index; }
+            bool operator>=(row_iterator const& other) const { return m_index >= other.m_index; }
+
+        private:
+
+            Offset const* m_offsets = nullptr;
+            T* m_values = nullptr;
+            size_t m_index = 0;
+
+        }; /* end class row_iterator */
+
+        using iterator = row_iterator;
+        using const_iterator = row_iterator;
+
+        // Constructors
+        vector2d_view() = default;
+
+        /**
+         * @param offsets the nrow + 1 ascending offsets starting at 0
+         * @param nrow the number of rows
+         * @param values the offsets[nrow] elements
+         *
+         * Time complexity: O(1)
+         */
+        vector2d_view(Offset const* offsets, size_t nrow, T* values) noexcept
+            : m_offsets(offsets), m_nrow(nrow), m_values(values) {}
+
+        /**
+         * @param offsets the ascending offsets starting at 0, whose size is the number of rows + 1
+         * @param values the offsets.back() elements
+         *
+         * Time complexity: O(1)
+         */
+        vector2d_view(std::span<Offset const> offsets, T* values) noexcept
+            : m_offsets(offsets.data()), m_nrow(offsets.empty() ? 0 : offsets.size() - 1), m_values(values) {}
+
+        // Iterators
+        row_iterator begin() const noexcept { return row_iterator(m_offsets, m_values, 0); }
+        row_iterator end() const noexcept { return row_iterator(m_offsets, m_values, m_nrow); }
+        row_iterator cbegin() const noexcept { return this->begin(); }
+        row_iterator cend() const noexcept { return this->end(); }
+
+        // Element access
+        std::span<T> at(size_t index) const
+        {
+            if (index >= m_nrow)
+            {
+                std::ostringstream ms;
+                ms << "ollib::vector2d_view::at(): input index " << index << " is out of range.";
+                throw std::out_of_range(ms.str());
+            }
+            return (*this)[index];
+        }
+        std::span<T> operator[](size_t index) const { return vector2d_view::row(m_offsets, m_values, index); }
+        std::span<T> row_span(size_t index) const { return (*this)[index]; }
+        std::span<T> front() const { return (*this)[0]; }
+        std::span<T> back() const { return (*this)[m_nrow - 1]; }
+
+        // Capacity
+        size_t size() const noexcept { return m_nrow; }
+        bool empty() const noexcept { return m_nrow == 0; }
+        size_t nelement() const noexcept { return m_nrow == 0 ? 0 : static_cast<size_t>(m_offsets[m_nrow]); }
+
+        // The offsets (size() + 1 elements) and the values which are viewed.
+        Offset const* offsets() const noexcept { return m_offsets; }
+        T* values() const noexcept { return m_values; }
+
+        // All elements of all rows, which are contiguous in a view.
+        std::span<T> elements() const noexcept { return std::span<T>(m_values, this->nelement()); }
+
+    private:
+
+        static std::span<T> row(Offset const* offsets, T* values, size_t index) noexcept
+        {
+            return std::span<T>(values + offsets[index], static_cast<size_t>(offsets[index + 1] - offsets[index]));
+        }
+
+        Offset const* m_offsets = nullptr;
+        size_t m_nrow = 0;
+        T* m_values = nullptr;
+
+    }; /* end class vector2d_view */
+
+}  // namespace ollib